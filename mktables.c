@@ -0,0 +1,196 @@
+/*
+mktables.c
+
+Writes pusoytab.h, the rule tables of pusoylib.c, to stdout.  Each table
+is built by walking the plays in order of strength and is then checked
+against the formulas the finders used to work the values out with, so
+that the build stops if the two ever disagree.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pusoy.h"
+
+static int choose[NUMCARDS][6];
+static comboval scale5[139];
+static int keybase[ROYALFLUSH + 2];	/* key of the weakest play of each kind,
+				   and the end of the scale */
+static int strtkey[10][4];	/* straight w with its top card of suit s */
+static int strtwin[10];		/* ranks of straight w */
+static int flushkey[4], sfkey[4], royalkey[4];
+static unsigned long long zcard[NUMCARDS], zseat[MAXPLAYERS + 2];
+static int errors = 0;
+
+static void check(int ok, char *what, int a, int b)
+{
+    if (ok) return;
+    fprintf(stderr, "mktables:  %s %d %d does not match\n", what, a, b);
+    errors++;
+}
+
+/* splitmix64 */
+static unsigned long long nextkey()
+{
+    static unsigned long long seed = 0x5075736f79446f73ULL;
+    unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void maketables()
+{
+    int i, j, w, s, key = 1;
+
+    for (i = 0; i < NUMCARDS; i++)
+    {
+	choose[i][0] = 1;
+	for (j = 1; j < 6; j++)
+	    choose[i][j] = i ? choose[i - 1][j - 1] + choose[i - 1][j] : 0;
+    }
+
+    /* straights:  A2345 up to 9TJQK then TJQKA, by the suit of the top */
+    keybase[STRAIGHT] = key;
+    for (w = 0; w < 10; w++)
+    {
+	for (strtwin[w] = 0, j = 0; j < 5; j++)
+	    strtwin[w] |= 1 << ((w + j + 11) % 13);
+	for (s = 0; s < 4; s++) strtkey[w][s] = key++;
+    }
+    /* flushes, suit by suit, from the top rank of the weakest one up */
+    keybase[FLUSH] = key;
+    for (s = 0; s < 4; s++)
+    {
+	flushkey[s] = key - 5;
+	key += 8;
+    }
+    keybase[FULLHOUSE] = key;
+    key += 13;
+    keybase[FOURKIND] = key;
+    key += 13;
+    /* straight flushes up to 9TJQK, suit by suit */
+    keybase[STRAIGHTFLUSH] = key;
+    for (s = 0; s < 4; s++)
+    {
+	sfkey[s] = key;
+	key += 9;
+    }
+    keybase[ROYALFLUSH] = key;
+    for (s = 0; s < 4; s++) royalkey[s] = key++;
+    keybase[ROYALFLUSH + 1] = key;
+
+    /* Zobrist keys, from a fixed seed so that every build agrees */
+    for (i = 0; i < NUMCARDS; i++) zcard[i] = nextkey();
+    for (i = 0; i < MAXPLAYERS + 2; i++) zseat[i] = nextkey();
+
+    for (i = 1, j = STRAIGHT; i < 139; i++)
+    {
+	while (i >= keybase[j + 1]) j++;
+	scale5[i] = COMBOVAL(5, j, i);
+    }
+}
+
+/* the values as the finders used to work them out */
+static void checktables()
+{
+    int w, s, r, top;
+
+    check(keybase[ROYALFLUSH + 1] == 139, "end of scale",
+	keybase[ROYALFLUSH + 1], 139);
+    for (w = 0; w < 9; w++) for (s = 0; s < 4; s++)
+    {
+	top = (w + 2) * 4 + s;
+	check(strtkey[w][s] == (top + 8) % NUMCARDS - 15, "straight", w, s);
+	check(sfkey[s] + w == (w + 2) + s * 9 + 97, "straight flush", w, s);
+    }
+    for (s = 0; s < 4; s++)
+    {
+	check(strtkey[9][s] == 44 + s - 7, "TJQKA", s, 0);
+	check(royalkey[s] == 135 + s, "royal flush", s, 0);
+	for (r = 5; r < 13; r++)
+	    check(flushkey[s] + r == 36 + r + s * 8, "flush", s, r);
+    }
+    check(flushkey[0] + 5 == keybase[FLUSH], "weakest flush",
+	flushkey[0] + 5, keybase[FLUSH]);
+    check(keybase[FULLHOUSE] == 73, "full house", keybase[FULLHOUSE], 73);
+    check(keybase[FOURKIND] == 86, "four of a kind", keybase[FOURKIND], 86);
+    check(strtwin[9] == (31 << 7), "TJQKA ranks", strtwin[9], 31 << 7);
+    check(strtwin[0] == (7 | (3 << 11)), "A2345 ranks", strtwin[0],
+	7 | (3 << 11));
+    check(choose[NUMCARDS - 1][5] + choose[NUMCARDS - 1][4] == 2598960,
+	"52 choose 5", choose[NUMCARDS - 1][5] + choose[NUMCARDS - 1][4],
+	2598960);
+}
+
+/* an int table of n entries, in rows of per entries if per is not 0 */
+static void putints(char *decl, int *t, int n, int per)
+{
+    int i;
+
+    printf("%s = {", decl);
+    for (i = 0; i < n; i++)
+    {
+	if (per) printf("%s%d", (i % per) ? ", " : (i ? " },\n    { " :
+	    "\n    { "), t[i]);
+	else printf("%s%s%d", i ? "," : "", (i % 10) ? " " : "\n    ", t[i]);
+    }
+    printf(per ? " } };\n" : " };\n");
+}
+
+static void putkeys(char *decl, unsigned long long *t, int n)
+{
+    int i;
+
+    printf("%s = {", decl);
+    for (i = 0; i < n; i++)
+	printf("%s%s0x%016llxULL", i ? "," : "", (i % 3) ? " " : "\n    ", t[i]);
+    printf(" };\n");
+}
+
+int main()
+{
+    int i;
+
+    maketables();
+    checktables();
+    if (errors) return 1;
+
+    printf("/* pusoytab.h:  made by mktables, do not edit */\n\n");
+    printf("/* 5 card combination table index:  n choose k */\n");
+    printf("static const int choose[NUMCARDS][6] = {");
+    for (i = 0; i < NUMCARDS; i++)
+	printf("%s\n    { %d, %d, %d, %d, %d, %d }", i ? "," : "", choose[i][0],
+	    choose[i][1], choose[i][2], choose[i][3], choose[i][4],
+	    choose[i][5]);
+    printf(" };\n");
+    printf("/* packed value of each betterthis value of 5 cards */\n");
+    printf("static const comboval scale5[139] = {");
+    for (i = 0; i < 139; i++)
+	printf("%s%s0x%x", i ? "," : "", (i % 6) ? " " : "\n    ", scale5[i]);
+    printf(" };\n");
+    printf("/* betterthis value of the weakest play of each kind of 5 cards,"
+	" and the end\nof the scale */\n");
+    putints("static const int keybase[ROYALFLUSH + 2]", keybase, 
+	ROYALFLUSH + 2, 0);
+    printf("/* straight w (A2345 = 0 ... TJQKA = 9) with a top card of suit s"
+	" */\n");
+    putints("static const int strtkey[10][4]", &strtkey[0][0], 40, 4);
+    printf("/* the ranks of straight w */\n");
+    putints("static const int strtwin[10]", strtwin, 10, 0);
+    printf("/* flush of suit s:  flushkey[s] + rank of the top card */\n");
+    putints("static const int flushkey[4]", flushkey, 4, 0);
+    printf("/* straight flush w of suit s:  sfkey[s] + w */\n");
+    putints("static const int sfkey[4]", sfkey, 4, 0);
+    printf("/* royal flush of suit s */\n");
+    putints("static const int royalkey[4]", royalkey, 4, 0);
+    printf("/* Zobrist keys of the cards */\n");
+    putkeys("static const unsigned long long zcard[NUMCARDS]", zcard, 
+	NUMCARDS);
+    printf("/* keys of the players' seats, the last play and the turn state"
+	" */\n");
+    putkeys("static const unsigned long long zseat[MAXPLAYERS + 2]", zseat,
+	MAXPLAYERS + 2);
+    return 0;
+}
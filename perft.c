@@ -0,0 +1,123 @@
+/*
+perft.c
+
+Counts every sequence of plays and passes the rules allow, to a given
+depth, from a set of seeded deals.  A hand in control may not pass, so
+a pass is counted only where the last play has to be beaten.  The counts at each depth are a check
+on the move generator and the speed is a check on its cost.  At each
+position it also checks that the computer's choice is among the plays
+counted, that playmove() takes every one of them and that playvalues() 
+values them as genmoves() does.
+
+Usage:  perft [-d depth] [-n deals] [-s first seed] [-p players]
+	[-c controlmode]
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pusoy.h"
+
+#define MAXDEPTH 8
+
+static struct MoveStruct moves[MAXDEPTH][MAXMOVES];
+static cardmask sets[MAXMOVES];
+static comboval values[MAXMOVES];
+static unsigned long long count[MAXDEPTH + 1];
+static long errors = 0;
+
+/* the plays open to the hand to play, and a pass if it is not in 
+control */
+static void perft(struct GameState *g, int depth, int ply)
+{
+    struct GameState next;
+    struct MoveStruct *m = moves[ply];
+    cardmask pick;
+    int i, n, pass = !g->firstdrop;
+
+    count[ply]++;
+    if ((ply == depth) || onehaslost(g)) return;
+    n = genmoves(g, g->turn, g->firstdrop, g->betterthis, m);
+    for (i = 0; i < n; i++) sets[i] = m[i].cards;
+    playvalues(sets, values, n);
+    for (i = 0; i < n; i++) if (values[i] != m[i].value) errors++;
+    if (makechoice(g, g->turn, g->firstdrop, g->betterthis, &pick))
+    {
+	for (i = 0; (i < n) && (m[i].cards != pick); i++);
+	if (i == n) errors++;
+    }
+    if (ply + 1 == depth)
+    {
+	count[ply + 1] += n + pass;
+	return;
+    }
+    for (i = 0; i < n + pass; i++)
+    {
+	next = *g;
+	if (!playmove(&next, (i < n) ? m[i].cards : 0)) errors++;
+	else perft(&next, depth, ply + 1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct GameState g = { 0 };
+    unsigned long long total = 0;
+    int i, depth = 4, deals = 10;
+    unsigned int seed = 1;
+    clock_t start;
+    double secs;
+
+    g.numplayers = 4;
+    g.controlmode = 1;
+    for (i = 1; i < argc; i++)
+    {
+	if ((argv[i][0] != '-') || (i + 1 == argc))
+	{
+	    fprintf(stderr, "Usage:  %s [-d depth] [-n deals] [-s first seed]"
+		" [-p players] [-c controlmode]\n", argv[0]);
+	    return 1;
+	}
+	switch (argv[i][1])
+	{
+	    case 'd': depth = atoi(argv[++i]); break;
+	    case 'n': deals = atoi(argv[++i]); break;
+	    case 's': seed = atoi(argv[++i]); break;
+	    case 'p': g.numplayers = atoi(argv[++i]); break;
+	    case 'c': g.controlmode = atoi(argv[++i]); break;
+	    default:
+		fprintf(stderr, "%s:  unknown option %s\n", argv[0], argv[i]);
+		return 1;
+	}
+    }
+    if ((depth < 1) || (depth > MAXDEPTH) || (g.numplayers < 2) ||
+	(g.numplayers > MAXPLAYERS))
+    {
+	fprintf(stderr, "%s:  depth goes from 1 to %d, players from 2 to %d\n",
+	    argv[0], MAXDEPTH, MAXPLAYERS);
+	return 1;
+    }
+
+    initcombo5();
+    start = clock();
+    for (i = 0; i < deals; i++)
+    {
+	g.seed = seed + i;
+	newgame(&g);
+	perft(&g, depth, 0);
+    }
+    secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%d deals from seed %u, %d players, controlmode %d\n", deals,
+	seed, g.numplayers, g.controlmode);
+    for (i = 0; i <= depth; i++)
+    {
+	printf("depth %d  %llu\n", i, count[i]);
+	total += count[i];
+    }
+    printf("%llu nodes in %.2f s, %.0f nodes/s\n", total, secs,
+	secs > 0 ? total / secs : 0.0);
+    if (errors) printf("%ld ERRORS\n", errors);
+    return errors != 0;
+}
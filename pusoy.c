@@ -3,6 +3,8 @@ Pusoy Dos program version 1.0
 
 Name:		Paolo Villaflores	
 Files:          pusoy.c
+		pusoy.h
+		pusoylib.c
                 makefile
 Code Desc:      This is a UNIX implementation of the card game PUSOY-DOS
                 for a single user. The rules as well as the hierarchy of
@@ -32,10 +34,12 @@ All rights reserved.
 #include <errno.h>
 #include <netdb.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include "pusoy.h"
 
 #ifndef A_UNDERLINE	/* BSD curses */
 #define	beep()	write(1,"\007",1);
@@ -63,8 +67,6 @@ extern void srand48();
 /* the following macro enables the displaying of opponents cards--for 
 debugging 
 #define SHOWCARDS */
-#define NUMCARDS 52
-#define MAXPLAYERS 4
 
 /* the file descriptor for stdin */
 #define STDIN 0
@@ -77,6 +79,21 @@ the server.  this is larger than the maximum number of clients because
 invalid transient connections may exist until the right number of connections
 has been verified */
 #define MAXCONNECTS 3
+/* how long a computer player thinks on its turn by default, in ms, the 
+size of each of its search trees and the most trees it has, one for each
+processor up to that.  a tree of TREENODES takes 3 MB, and twice that for 
+a moment while a search takes up the part of it still wanted */
+#define THINKTIME 1000
+#define TREENODES 65536
+#define SEARCHTREES 4
+/* two handed endings with at most ENDGAME cards left are played exactly,
+by a search that gives up after SOLVENODES positions */
+#define ENDGAME 18
+#define SOLVENODES 2000000
+#define SOLVESLOTS 262144
+/* the longest the computer players ponder while waiting on one key, in 
+ms */
+#define PONDERTIME 60000
 static char name[48];
 static char progname[128];
 static char dfltname[] = "human on this terminal";
@@ -92,25 +109,22 @@ mesgtype;
 
 mesgtype mesgbuffer;
 
-struct DeckStruct
-{
-    int deck[NUMCARDS];
-    int held;
-} hand[MAXPLAYERS + 4],  /* 0-3 for players; 4 for discards; 5 for last */
-			 /* play; 6&7 for scratch space */
 #ifdef DEBUGGING
-handdebug[4]		 /* an image of original deck, used for debugging */
+struct DeckStruct handdebug[4];	/* an image of original deck, used for debugging */
 #endif
-;
+
+struct GameState game = { 4, 0, 1 };	/* the game played on this terminal */
+struct Searcher searcher[MAXPLAYERS];	/* the computer players' trees */
+struct Solver solver;		/* and their endings */
+struct Planner planner;		/* for makechoice() only, not the search */
+struct Tracker tracker;		/* what the passes tell of the hands */
 
 #define BACKLOG 5
 
-int numplayers = 4;	/* the number of players in the game */
-int discard = 0;	/* the number of cards to discard */
 int thisplayer = 0;	/* which hand does this player hold */
-int controlmode = 1;    /* how control transfers */
 int dispvar = 1;	/* controls whether number of cards is displayed */
 int networkgame = 0;	/* controls whether a network game is to be played */
+int thinktime = THINKTIME;	/* of each computer turn, in ms */
 unsigned short int serv_port = 5678;	/* default server port value */
 int socketnum, new_fd[MAXCONNECTS], verified[MAXCONNECTS];
 int sin_size;
@@ -123,8 +137,10 @@ struct hostent *he;
 struct {
     int networkgame, numplayers, discard, thisplayer, controlmode, dispvar;
     char name[48];
-    int turn, firstdrop, betterthis, pid;
+    int turn, firstdrop, pid;
+    comboval betterthis;
     struct DeckStruct hand;
+    cardmask combo;	/* the cards thrown from hand, none for a pass */
 } messagebuf, messagerec[4];
 
 
@@ -133,11 +149,19 @@ struct {
 FILE *fdbg;		/* log file */
 #endif
 
+#ifdef DEBUGGING
+static void logcards(cardmask m)
+{
+    for (; m; m &= m - 1) fprintf(fdbg, "%d %c%c\n", lowcard(m), 
+	ranks[lowcard(m)/4], suits[lowcard(m)%4]);
+}
+#endif
+
 /* end the game, either normally or due to signal */
 static void uninitgame(int sig)
 {
 #ifdef DEBUGGING
-    int i, j;	
+    int i;	
 #endif
 
     clear();
@@ -147,17 +171,15 @@ static void uninitgame(int sig)
     (void)endwin();
 #ifdef DEBUGGING
     fprintf(fdbg,"DEBUG RECORDS\n");
-    fprintf(fdbg, "%d\n", numplayers);
+    fprintf(fdbg, "%d\n", game.numplayers);
     fprintf(fdbg, "%s\n", suits);
-    fprintf(fdbg, "%d\n", controlmode);
-    fprintf(fdbg, "%d\n", discard);
-    for (i = 0; i < numplayers; i++)
+    fprintf(fdbg, "%d\n", game.controlmode);
+    fprintf(fdbg, "%d\n", game.discard);
+    for (i = 0; i < game.numplayers; i++)
     {
 	fprintf(fdbg, "PLAYER RECORD\n");
 	fprintf(fdbg, "%d\n", handdebug[i].held);
-	for (j = 0; j < handdebug[i].held; j++) fprintf(fdbg, "%d %c%c\n",
-	    handdebug[i].deck[j], ranks[handdebug[i].deck[j]/4], 
-	    suits[handdebug[i].deck[j]%4]);
+	logcards(handdebug[i].cards);
     }
     fclose(fdbg);
 #endif
@@ -167,7 +189,7 @@ static void uninitgame(int sig)
 static void fatal(char *s)
 {
 #ifdef DEBUGGING
-    int i, j;	
+    int i;	
 #endif
 
     clear();
@@ -178,48 +200,21 @@ static void fatal(char *s)
     (void)fprintf(stderr, "%s:  fatal error:  %s\n", progname, s);
 #ifdef DEBUGGING
     fprintf(fdbg,"DEBUG RECORDS\n");
-    fprintf(fdbg, "%d\n", numplayers);
+    fprintf(fdbg, "%d\n", game.numplayers);
     fprintf(fdbg, "%s\n", suits);
-    fprintf(fdbg, "%d\n", controlmode);
-    fprintf(fdbg, "%d\n", discard);
-    for (i = 0; i < numplayers; i++)
+    fprintf(fdbg, "%d\n", game.controlmode);
+    fprintf(fdbg, "%d\n", game.discard);
+    for (i = 0; i < game.numplayers; i++)
     {
 	fprintf(fdbg, "PLAYER RECORD\n");
 	fprintf(fdbg, "%d\n", handdebug[i].held);
-	for (j = 0; j < handdebug[i].held; j++) fprintf(fdbg, "%d %c%c\n",
-	    handdebug[i].deck[j], ranks[handdebug[i].deck[j]/4], 
-	    suits[handdebug[i].deck[j]%4]);
+	logcards(handdebug[i].cards);
     }
     fclose(fdbg);
 #endif
     exit(0);
 }
 
-static int mycompar(const void *a, const void *b)
-{
-    if (*((int *)a) < *((int *)b)) return -1;
-    return *((int *)a) > *((int *)b);
-}
-
-static int tlate(int val)
-{
-    return (val + 8) % NUMCARDS;
-}
-
-static int mystrtcompar(const void *a, const void *b)
-{
-    if (tlate((*((int *)b) & 63)) > 
-	tlate((*((int *)a) & 63))) return -1; 
-    return tlate((*((int *)b) & 63)) < 
-	tlate((*((int *)a) & 63)); 
-}
-
-static void sortcard(int i)
-{
-    qsort((void *)&hand[i].deck[0], (size_t)hand[i].held, 
-	(size_t)sizeof(hand[i].deck[0]), mycompar); 
-}
-
 static void mvcaddstr(int y, char *s)
 {
     char temp[80];
@@ -381,1477 +376,215 @@ static void drawcard(int aty, int atx, int crd)
     delwin(cardw);
 }
 
-static void shuffle()
-{
-    int i, dist, curply = 0;
-    int crdhold[NUMCARDS];
-
-    for (i = 0; i < MAXPLAYERS + 2; i++) hand[i].held = 0;
-    for (i = 0; i < NUMCARDS; i++) crdhold[i] = 0;
-    for (dist = 0; dist < NUMCARDS - discard; dist++) 
-    {
-	i = (i + rand()) % NUMCARDS;
-	while (crdhold[i]) i = (i + 1) % NUMCARDS;
-	crdhold[i] = 1;
-	hand[curply].deck[hand[curply].held++] = i;
-        curply = (curply + 1) % numplayers;
-    }
-    for (i = 0; i < numplayers; i++) sortcard(i);
-#ifdef DEBUGGING
-    for (i = 0; i < 4; i++) handdebug[i] = hand[i];
-#endif
-}
+/* the 24 orders of the suits, in the order the menu steps through them */
+static char *suitorders[24] = {
+    "CDHS", "CDSH", "CHDS", "CHSD", "CSDH", "CSHD",
+    "DCHS", "DCSH", "DHCS", "DHSC", "DSCH", "DSHC",
+    "HCDS", "HCSD", "HDCS", "HDSC", "HSCD", "HSDC",
+    "SCDH", "SCHD", "SDCH", "SDHC", "SHCD", "SHDC" };
+static int suitorder = 6;	/* suits[] is suitorders[suitorder] */
 
-static int whosfirst()
+static void nextsuitscombi()
 {
-    int i, j, min;
-
-    i = 0;
-    min = hand[0].deck[0];
-    for (j = 1; j < numplayers; j++)
-    {
-	if (min > hand[j].deck[0])
-	{
-	    min = hand[j].deck[0];
-	    i = j;
-	}
-    }
-    return i;
+    suitorder = (suitorder + 1) % 24;
+    strcpy(suits, suitorders[suitorder]);
 }
 
-/* combination of NUM cards to check */		
-#define NUM 	13
-/* constant needed to get flush value */
-#define FLSHCNV 36	
-/******* look for flush starts here *******/
-static int lookforflush(int who, int betterthis)
-{
-    int diamonds[NUM];	/* array to hold indices of cards with */ 
-    int hearts[NUM];	/* the specified suit */
-    int spades[NUM];
-    int clubs[NUM];
-    int suit, i=0, diamondc=0, heartc=0, spadec=0, clubc=0, cardval=0;
-
-    sortcard(who);
-    for (i=0; i<NUM; i++)
-    {
-	diamonds[i] = -1;
-	hearts[i] = -1;
-	spades[i] = -1;
-	clubs[i] = -1;
-    }
-    for (i=0; i<hand[who].held; i++)
-    {
-	suit = hand[who].deck[i] % 4;
-	switch (suit)
-	{
-    	    case 0: clubs[clubc++] = i; break;
-    	    case 1: spades[spadec++] = i; break;
-    	    case 2: hearts[heartc++] = i; break;   	    
-    	    case 3: diamonds[diamondc++] = i; break;
-	}
-    }
-    for (i=4; i<clubc; i++)
-    {
-    	cardval = hand[who].deck[clubs[i]]/4;
-	if (((cardval+=FLSHCNV) > betterthis) && (clubs[i] > 0))
-	{
-	    if (who != thisplayer)
-	    {
-	    	hand[who].deck[clubs[0]] |= 128;
-	    	hand[who].deck[clubs[1]] |= 128;
-	    	hand[who].deck[clubs[2]] |= 128;
-	    	hand[who].deck[clubs[3]] |= 128;
-	    	hand[who].deck[clubs[i]] |= 128;
-	    }
-	    return (cardval);
-	}
-    }
-    for (i=4; i<spadec; i++)
-    {
-    	cardval = hand[who].deck[spades[i]]/4 + 8;
-	if (((cardval+=FLSHCNV) > betterthis) && (spades[i] > 0))
-	{
-	    if (who != thisplayer)
-	    {
-	    	hand[who].deck[spades[0]] |= 128;
-	    	hand[who].deck[spades[1]] |= 128;
-	    	hand[who].deck[spades[2]] |= 128;
-	    	hand[who].deck[spades[3]] |= 128;
-	    	hand[who].deck[spades[i]] |= 128;
-	    }
-	    return (cardval);
-	}
-    }
-    for (i=4; i<heartc; i++)
-    {
-    	cardval = hand[who].deck[hearts[i]]/4 + 16;
-	if (((cardval+=FLSHCNV) > betterthis) && (hearts[i] > 0))
-	{
-	    if (who != thisplayer)
-	    {
-	    	hand[who].deck[hearts[0]] |= 128;
-	    	hand[who].deck[hearts[1]] |= 128;
-	    	hand[who].deck[hearts[2]] |= 128;
-	    	hand[who].deck[hearts[3]] |= 128;
-	    	hand[who].deck[hearts[i]] |= 128;
-	    }
-	    return (cardval);
-	}
-    }
-    for (i=4; i<diamondc; i++)
-    {
-    	cardval = hand[who].deck[diamonds[i]]/4 + 24;
-	if (((cardval+=FLSHCNV) > betterthis) && (diamonds[i] > 0))
-	{
-	    if (who != thisplayer)
-	    {
-	    	hand[who].deck[diamonds[0]] |= 128;
-	    	hand[who].deck[diamonds[1]] |= 128;
-	    	hand[who].deck[diamonds[2]] |= 128;
-	    	hand[who].deck[diamonds[3]] |= 128;
-	    	hand[who].deck[diamonds[i]] |= 128;
-	    }
-	    return (cardval);
-	}
-    }
-    return 0;
-}
-#undef NUM
-#undef FLSHCNV
+/* how far the user has pushed up the cards of the hand:  a card in
+lift[0] only is up one level, in lift[1] only two and in both three */
+static cardmask lift[2];
 
-#define NUM	13	/* number of cards to check */
-#define STRFLSH	97	/* constant needed to get straight flush value */
-#define MARK 	128	/* ORed with card value to mark flush */
-static int lookforstraightflush(int who, int betterthis)
-{
-    int i=0, j=0, k=0, l=0;
-    int max=0, index=0;
-    int club=0, spade=0, heart=0, diamond=0, min=0;	
-    int diffclub=0, diffspade=0, diffheart=0, diffdiamond=0;
-    int diamonds[NUM];		/* array to hold cards with */ 
-    int hearts[NUM];		/* the specified suit */
-    int spades[NUM];
-    int clubs[NUM];
-    int clubc=0, spadec=0, heartc=0, diamondc=0;	
-
-    qsort((void *)&hand[who].deck[0], (size_t)hand[who].held, 
-	(size_t)sizeof(hand[who].deck[0]), mystrtcompar);
-
-    for (i=0; i<hand[who].held; i++)
-    {
-	switch (hand[who].deck[i]%4)
-	{
-	    case 0:
-		clubs[clubc++]=hand[who].deck[i];
-		break; 
-	    case 1:
-		spades[spadec++]=hand[who].deck[i];
-		break;
-	    case 2:
-		hearts[heartc++]=hand[who].deck[i];
-		break;
-	    case 3:
-		diamonds[diamondc++]=hand[who].deck[i];
-		break;
-	}
-    }
-    
-    min = tlate(clubs[0])/4;
-    for (i=1; i<clubc; i++)
-    {
-	if ((tlate(clubs[i])/4 - tlate(clubs[i-1])/4) == 1)
-	{ 
-	    club = clubs[i];
-   	    max = tlate(clubs[i])/4;
-	    diffclub = max - min; 
-	    if ((diffclub >= 4) && ((club/4 + club%4*9 + STRFLSH) 
-		> betterthis)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (club/4 + club%4*9 + STRFLSH);
-		for (j=0; j<NUM; j++) 
-		{		
-		    if (club == clubs[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-4); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == clubs[k])
-		   	hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (club/4 + club%4*9 + STRFLSH);
-            }
-	}
-	else min = tlate(clubs[i])/4;
-    }
-  
-    min = tlate(spades[0])/4;
-    for (i=1; i<spadec; i++)
-    {
-	if ((tlate(spades[i])/4 - tlate(spades[i-1])/4) == 1)
-	{ 
-	    spade = spades[i]; 
-   	    max = tlate(spades[i])/4;
-	    diffspade = max - min;		
-	    if ((diffspade >= 4) && ((spade/4 + spade%4*9 + STRFLSH) 
-		> betterthis)) 
-	    {    
-		if (who == thisplayer) 
-	    	    return (spade/4 + spade%4*9 + STRFLSH);
-		for (j=0; j<NUM; j++) 
-		{
-		    if (spade == spades[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-4); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == spades[k])
-		   	hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (spade/4 + spade%4*9 + STRFLSH);
-            }
-	}
-	else min = tlate(spades[i])/4;
-    }
-    
-    min = tlate(hearts[0])/4;
-    for (i=1; i<heartc; i++)
-    {
-	if ((tlate(hearts[i])/4 - tlate(hearts[i-1])/4) == 1)
-	{ 		
-	    heart = hearts[i]; 
-   	    max = tlate(hearts[i])/4;
-	    diffheart = max - min;		
-	    if ((diffheart >= 4) && ((heart/4 + heart%4*9 + STRFLSH) 
-		> betterthis))
-	    {    
-		if (who == thisplayer) 
-	    	    return (heart/4 + heart%4*9 + STRFLSH);
-		for (j=0; j<NUM; j++) 
-		{
-		    if (heart == hearts[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-4); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == hearts[k])
-		   	hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (heart/4 + heart%4*9 + STRFLSH);
-            }
-	}
-	else min = tlate(hearts[i])/4;
-    }
-    
-    min = tlate(diamonds[0])/4;
-    for (i=1; i<diamondc; i++)
-    {
-	if ((tlate(diamonds[i])/4 - tlate(diamonds[i-1])/4) == 1)
-	{ 	
-	    diamond = diamonds[i]; 
-   	    max = tlate(diamonds[i])/4;
-	    diffdiamond = max - min;
-	    if ((diffdiamond >= 4) && ((diamond/4 + diamond%4*9 + STRFLSH) 
-		> betterthis)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (diamond/4 + diamond%4*9 + STRFLSH);
-		for (j=0; j<NUM; j++) 
-		{
-		    if (club == clubs[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-4); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == diamonds[k])
-		   	hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (diamond/4 + diamond%4*9 + STRFLSH);
-            }
-	}
-	else min = tlate(diamonds[i])/4;
-    }
-    return 0;
-}
-#undef NUM
-#undef STRFLSH	
-#undef MARK 
-/******* look for straight flush ends here *******/ 
-
-/******* look for royal flush starts here *******/
-#define NUM	13	/* number of cards to check */
-#define MARK 	128	/* ORed with card value to mark flush */
-static int lookforroyalflush(int who, int betterthis)
+/* cards of hand who shown at a given raise level (0 = down, 3 = highest) */
+static cardmask levelcards(int who, int level)
 {
-    int i=0, j=0, k=0, l=0;
-    int max=0, index=0;
-    int club=0, spade=0, heart=0, diamond=0, min=0;	
-    int diffclub=0, diffspade=0, diffheart=0, diffdiamond=0;
-    int diamonds[NUM];		/* array to hold cards with */ 
-    int hearts[NUM];		/* the specified suit */
-    int spades[NUM];
-    int clubs[NUM];
-    int clubc=0, spadec=0, heartc=0, diamondc=0;	  
-
-    qsort((void *)&hand[who].deck[0], (size_t)hand[who].held, 
-	(size_t)sizeof(hand[who].deck[0]), mystrtcompar);
-
-    for (i=0; i<hand[who].held; i++)
-    {
-	switch (hand[who].deck[i]%4)
-	{
-	    case 0:
-		clubs[clubc++]=hand[who].deck[i];
-		break; 
-	    case 1:
-		spades[spadec++]=hand[who].deck[i];
-		break;
-	    case 2:
-		hearts[heartc++]=hand[who].deck[i];
-		break;
-	    case 3:
-		diamonds[diamondc++]=hand[who].deck[i];
-		break;
-	}
-    }
-    
-    min = tlate(clubs[0])/4;
-    for (i=1; i<clubc; i++)
-    {
-	if ((tlate(clubs[i])/4 - tlate(clubs[i-1])/4) == 1)
-	{ 
-	    club = clubs[i];
-   	    max = tlate(clubs[i])/4;
-	    diffclub = max - min; 
-	    if ((diffclub == 3) && (135 > betterthis) && 
-		(min == 9) && (tlate(clubs[0])/4 == 0)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (135);
-		for (j=0; j<NUM; j++) 
-		{		
-		    if (club == clubs[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-3); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == clubs[k])
-		   	    hand[who].deck[l] |= MARK;
-			if (hand[who].deck[l] == clubs[0])
-			    hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (135);
-            }
-	}
-	else min = tlate(clubs[i])/4;
-    }
-  
-    min = tlate(spades[0])/4;
-    for (i=1; i<spadec; i++)
-    {
-	if ((tlate(spades[i])/4 - tlate(spades[i-1])/4) == 1)
-	{ 
-	    spade = spades[i]; 
-   	    max = tlate(spades[i])/4;
-	    diffspade = max - min;		
-	    if ((diffspade == 3) && (136 > betterthis) && 
-		(min == 9) && (tlate(spades[0])/4 == 0)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (136);
-		for (j=0; j<NUM; j++) 
-		{		
-		    if (spade == spades[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-3); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == spades[k])
-		   	    hand[who].deck[l] |= MARK;
-			if (hand[who].deck[l] == spades[0])
-			    hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (136);
-            }
-	}
-	else min = tlate(spades[i])/4;
-    }
-    
-    min = tlate(hearts[0])/4;
-    for (i=1; i<heartc; i++)
-    {
-	if ((tlate(hearts[i])/4 - tlate(hearts[i-1])/4) == 1)
-	{ 		
-	    heart = hearts[i]; 
-   	    max = tlate(hearts[i])/4;
-	    diffheart = max - min;		
-	    if ((diffheart == 3) && (137 > betterthis) && 
-		(min == 9) && (tlate(hearts[0])/4 == 0)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (137);
-		for (j=0; j<NUM; j++) 
-		{		
-		    if (heart == hearts[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-3); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == hearts[k])
-		   	    hand[who].deck[l] |= MARK;
-			if (hand[who].deck[l] == hearts[0])
-			    hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (137);
-            }
-	}
-	else min = tlate(hearts[i])/4;
-    }
-    
-    min = tlate(diamonds[0])/4;
-    for (i=1; i<diamondc; i++)
-    {
-	if ((tlate(diamonds[i])/4 - tlate(diamonds[i-1])/4) == 1)
-	{ 	
-	    diamond = diamonds[i]; 
-   	    max = tlate(diamonds[i])/4;
-	    diffdiamond = max - min;
-	    if ((diffdiamond == 3) && (138 > betterthis) && 
-		(min == 9) && (tlate(diamonds[0])/4 == 0)) 
-	    {    
-		if (who == thisplayer)
-	    	    return (138);
-		for (j=0; j<NUM; j++) 
-		{		
-		    if (diamond == diamonds[j]) 
-			index = j;
-		}
-	        for (k=index; k>=(index-3); k--)
-	        {
-	    	    for (l=0; l<hand[who].held; l++)
-	    	    {
-		    	if (hand[who].deck[l] == diamonds[k])
-		   	    hand[who].deck[l] |= MARK;
-			if (hand[who].deck[l] == diamonds[0])
-			    hand[who].deck[l] |= MARK;
-	    	    }
-	    	}
-	    	return (138);
-            }
-	}
-	else min = tlate(diamonds[i])/4;
-    } 
-    return 0;
-}
-#undef NUM
-#undef MARK
-/******* look for royal flush ends here *******/ 
-
-#define FOURCNV	86
-/******* look for four-of-a-kind starts here *******/
-static int lookfor4(int who, int betterthis)
-{
-    int i, index=0, flag=0, number=0;
-    int single=-1, pair=-1, trio=-1, quad=-1;
-    int list[13];
+    cardmask r = 0, m = 0;
 
-    sortcard(who);
-    for (i=0; i<13; i++) list[i] = 0;
-    for (i=0; i<hand[who].held; i++)
-    {
-	index = hand[who].deck[i]/4;
-	list[index] += 1; 	
-    }
-    for (i=0; i<13; i++)
-    {
-	if ((list[i] == 4) && (i > (betterthis-FOURCNV))) 
-	{
-	    flag = 1;
-	    number = i;
-	    break;
-	}
-    }
-    if (flag == 1) 
+    if (who == thisplayer)
     {
-	betterthis = number + FOURCNV;
-	if (who != thisplayer)
-	{
-	    for (i=0; i<hand[who].held; i++)
-	    {
-	    	if (hand[who].deck[i]/4 == number) 
-		    hand[who].deck[i] |= 128;
-	    }
-	    for (i=0; i<13; i++)
-	    {
-		switch (list[i])
-		{
-		    case 1:
-			if (single < 0) single = i; 
-			break;
-		    case 2: 
-			if (pair < 0) pair = i; 
-			break;
-		    case 3: 
-			if (trio < 0) trio = i; 
-			break;
-		    case 4: 
-			if (quad < 0) quad = i; 
-			break;
-		}
-  	    }
-	    if ((single > 7) && (pair >= 0) && ((single-pair) >= 4))
-	    {
-	    	for (i=0; i<hand[who].held; i++)
-	    	{
-	    	    if (hand[who].deck[i]/4 == pair)
-		    { 
-		    	hand[who].deck[i] |= 128;
-		    	return betterthis;
-		    }
-	    	}
-	    }
-	    else if (single >= 0)
-	    {
-	    	for (i=0; i<hand[who].held; i++)
-	    	{
-	    	    if (hand[who].deck[i]/4 == single) 
-		    {
-			hand[who].deck[i] |= 128;
-		    	return betterthis;
-		    }
-	    	}
-	    }
-	    else if (pair >= 0)
-	    {
-	    	for (i=0; i<hand[who].held; i++)
-	    	{
-	    	    if (hand[who].deck[i]/4 == pair) 
-		    {
-			hand[who].deck[i] |= 128;
-			return betterthis;
-		    }
-	    	}
-	    }
-	    else if (trio >= 0)
-	    {
-	    	for (i=0; i<hand[who].held; i++)
-	    	{
-	    	    if (hand[who].deck[i]/4 == trio) 
-		    	hand[who].deck[i] |= 128;
-		    return betterthis;
-	    	}
-	    }
-	    else if (quad >= 0)
-	    {
-	    	for (i=0; i<hand[who].held; i++)
-	    	{
-	    	    if (hand[who].deck[i]/4 == quad) 
-		    {
-			hand[who].deck[i] |= 128;
-		    	return betterthis;
-		    }
-	    	}
-	    }
-	}
-	return betterthis;
+	r = lift[0]; m = lift[1];
     }
-    return 0; 
-}
-/******* look for four-of-a-kind ends here *******/ 
-#undef FOURCNV
 
-#define FULLCNV 73
-static int lookforfull(int who, int betterthis)
-{
-    int LIST[13];
-    int trio = -1, duo = -1;
-    int i = 0, index = 0, ctr3 = 0, ctr2 = 0;
-    int stat3 = 0;
-    int stat2 = -1, stat2by3 =-1, stat2by4 = -1;
-
-    sortcard(who);
-    for (i = 0; i < 13; i++) LIST[i] = 0;
-
-    for (i=0; i<hand[who].held; i++)
-    {
-	index = hand[who].deck[i]/4; /* to know card value */
-	LIST[index] += 1;
-    }
-    for (i=0; i<13; i++)
+    switch (level)
     {
-   	if ((LIST[i] == 3) && (i > betterthis-FULLCNV))  
-	{
-	    trio = i; stat3 = 1; break;
-	}
-	
+	case 0: return game.hand[who].cards & ~(r | m);
+	case 1: return game.hand[who].cards & r & ~m;
+	case 2: return game.hand[who].cards & m & ~r;
     }
-    if (stat3==0) 
-    {
-	for (i=0; i < 13; i++)
-	{
-	    if ((LIST[i] == 4) && (i > (betterthis-FULLCNV)))
-	    {
-		trio = i; break;
-	    }
-	}
-    } /* end stat3==0 */
-    if (trio < 0) return 0;
-    for (i=0; i < 13; i++)
-    {
-        if ((LIST[i] == 2) && (stat2 < 0)) stat2 = i;
-	if ((LIST[i] == 3) && (stat2by3 < 0) && (i != trio)) stat2by3 = i;
-	if ((LIST[i] == 4) && (stat2by4 < 0) && (i != trio)) stat2by4 = i;
-    }
-    if ((stat2 > 7) && (stat2by3 > -1) && (stat2by3 < (stat2-4))) 
-	duo = stat2by3;
-    else if (stat2 > -1)    duo = stat2;
-    else if (stat2by3 > -1) duo = stat2by3;
-    else if (stat2by4 > -1) duo = stat2by4;
-
-    if ((trio >= 0) && (duo >= 0)) 
-    {
-	for (i=0; i < hand[who].held; i++)
-	{
-    	    if ((trio == (hand[who].deck[i] / 4)) && (ctr3 < 3))
-	    {
-		hand[who].deck[i] |= 128; ctr3++;
-            }
-	    if ((duo == (hand[who].deck[i] / 4)) && (ctr2 < 2))
-	    {
-		hand[who].deck[i] |= 128; ctr2++;
-	    }
-	}
-	return (trio + FULLCNV);	
-    }
-    return 0;
+    return game.hand[who].cards & r & m;
 }
-#undef FULLCNV
 
-static int lookforstraight(int who, int betterthis) 
+static int cardlevel(int who, int crd)
 {
-    int i, j, k, lowval, prev;
-    int marks[5];
-
-    qsort((void *)&hand[who].deck[0], (size_t)hand[who].held, 
-	(size_t)sizeof(hand[who].deck[0]), mystrtcompar); 
-    for (i = 0; i < 5; i++) marks[i] = 0;
-    lowval = prev = hand[who].deck[0];
-    i = 1;
-    while (i < hand[who].held)
-    {
-	if ((tlate(hand[who].deck[i])/4 - 1) == (tlate(prev)/4)) 
-	{
-	    prev = hand[who].deck[i];
-	    marks[tlate(prev)/4 - tlate(lowval)/4] = i;
-	}
-	else if ((tlate(hand[who].deck[i])/4) > (tlate(prev)/4 + 1))
-	{
-	    lowval = prev = hand[who].deck[i];
-	    marks[0] = i;
-	}
-/*	else
-	{
-	    wmove(stdscr, 9, 0);
-	    printw("%d:%d lowval %d prev %d", tlate(lowval), tlate(prev), lowval, prev);
-            for (i = 0; i < hand[who].held; i++) printw("%c%c ",
-	        ranks[hand[who].deck[i]/4], suits[hand[who].deck[i]%4]); 
-	    refresh(); getch(); fatal("error in lookforstraight");
-        }*/
-	i++;
-        if ((tlate(prev)/4 - tlate(lowval)/4) == 4)
-	{
-/*	    wmove(stdscr, 7,0);
-	    printw("%d %c%c %c%c %d %d", i, ranks[lowval/4], suits[lowval%4], 
-	    	ranks[prev/4], suits[prev%4], lowval, prev);
-	    refresh();
-	    getch();*/
-	    if ((tlate(prev) - 15) <= betterthis) 
-	    {
-		if ((i < hand[who].held) && (tlate(hand[who].deck[i])/4 ==
-		    tlate(hand[who].deck[i - 1])/4))
-		{
-/*	    	    printw("here i %d %d",i,marks[3]);
-	    	    refresh();
-	    	    getch();*/
-		    prev = hand[who].deck[marks[3]];
-		}
-		else
-		{
-		    lowval = hand[who].deck[(int)marks[1]];
-		    for (j = 0; j < 5; j++) marks[j] = marks[j + 1];
-		}
-	    }
-	    else
-	    {
-		if (who == thisplayer) return (tlate(prev) - 15);
-		for (j = 0; j < 5; j++) hand[who].deck[(int)marks[j]] |= 128;
-		return (tlate(prev) - 15);
-	    }
-	}
-    }
-    i = 0;
-    /* special handler for TJQKA combo */
-    while (((prev/4 - lowval/4) == 3) && (hand[who].deck[i]/4 == 11) &&
-	(prev / 4 == 10))
-    {
-        if ((k = (hand[who].deck[i] - 7)) > betterthis)
-	{
-	    for (j = 0; j < 4; j++) hand[who].deck[(int)marks[j]] |= 128;
-	    hand[who].deck[i] |= 128;
-	    sortcard(who);
-	    return k; 
-	}
-	i++;
-    } 
-    return 0;
+    if (who != thisplayer) return 0;
+    return ((lift[0] >> crd) & 1) | (((lift[1] >> crd) & 1) << 1);
 }
 
-static int isstraightflush(int who)
+/* hand who in display order, lower levels to the left */
+static int showorder(int who, int *deck)
 {
-    int i = 0, j = 0, suit = 10;
-    int rack[5];
-
-    if (hand[who].held < 5) return 0;
-    while ((suit == 10) && (j < hand[who].held))
-    {
-	if ((who == thisplayer) || (who >= MAXPLAYERS))
-	{
-	    suit = hand[who].deck[j] % 4;
-	    rack[i++] = hand[who].deck[j];
-	}
-	else if (hand[who].deck[j] & 128)
-	{
-	    suit = (hand[who].deck[j] & 63) % 4;
-	    rack[i++] = hand[who].deck[j] & 63;
-	}
-	j++;
-    }
-    if (suit == 10) fatal("isstraightflush called with no card marked");
-    while (j < hand[who].held)
-    {
-	if ((who != thisplayer) && !(hand[who].deck[j] & 128) &&
-	    (who < MAXPLAYERS))
-	{
-	    j++; continue;
-	}
-	if (((hand[who].deck[j] & 63) % 4) != suit) return 0;
-	rack[i++] = hand[who].deck[j] & 63;
-	j++;
-    }
+    int level, n = 0;
 
-    qsort((void *)&rack[0], (size_t)5, 
-	(size_t)sizeof(rack[0]), mystrtcompar);
-    for (j = 0; j < 4; j++)
-	if ((tlate(rack[j])/4 + 1) != (tlate(rack[j + 1])/4)) break;
-
-    if (j == 0)	/* handler for TJQKA--royal flush */
-    {
-	qsort((void *)&rack[0], (size_t)5, 
-	    (size_t)sizeof(rack[0]), mycompar);
-	for (j = 0; j < 4; j++) if ((rack[j] + 4) != rack[j + 1]) return 0;
-	return suit + 135;
-    }
-    if (j == 4) return (suit * 9) + rack[4]/4 + 97;
-    return 0;
-}
-
-static int lookfor5(int who, int betterthis)
-{
-    int i;
-    /* better this:
-	straight 	1 ... 40
-	flush		41 ... 72
-	full house 	73 ... 85
-	four of a kind	86 ... 98
-	straight flush  99 ... 134
-	royal flush	135 ... 138 */
-
-    if (hand[who].held < 5) return 0;
-
-    if ((i = lookforstraight(who, betterthis))) return i;
-    if ((i = lookforflush(who, betterthis))) return i;
-    if ((i = lookforfull(who, betterthis))) return i;
-    if ((i = lookfor4(who, betterthis))) return i;
-    if ((i = lookforstraightflush(who, betterthis))) return i;
-    if ((i = lookforroyalflush(who, betterthis))) return i;
-    sortcard(who);
-    return 0;
+    for (level = 0; level < 4; level++)
+	n += maskcards(levelcards(who, level), deck + n);
+    return n;
 }
 
-static int lookfor3(int who, int betterthis)
+/* the card under cursor position pos */
+static int cardat(int who, int pos)
 {
-    int i = 0, rackp = 0, rank = 0;
-    int rack[3];
-
-    sortcard(who);
-    if (hand[who].held < 3) return 0;
-    while (i < hand[who].held)
-    {
-	if (hand[who].deck[i]/4 == rank)
-	{
-	    rack[rackp++] = i;
-	    if (rackp == 3)
-	    {
-		if ((rank + 1) > betterthis)
-		{
-		    for (rackp = 0; rackp < 3; rackp++) 
-			hand[who].deck[(int)rack[rackp]] |= 128;
-		    return rank + 1;
-		}
-		else rackp = 0;
-	    }
-	}
-	else 
-	{
-	    rank = hand[who].deck[i] / 4; rackp = 1; rack[0] = i;
-	}
-	i++;
-    }    
-    return 0;
-}
-
-static int lookfor2(int who, int betterthis)
-{
-    int i = 0, rackp = 0, rank = 0;
-    int rack[2];
-
-    sortcard(who);
-    if (hand[who].held < 2) return 0;
-    while (i < hand[who].held)
-    {
-	if (hand[who].deck[i]/4 == rank)
-	{
-	    rack[rackp++] = i;
-	    if (rackp == 2)
-	    {
-		/* betterthis val is already that of curr card */
-		if (hand[who].deck[i] > betterthis)
-		{
-		    for (rackp = 0; rackp < 2; rackp++)
-			hand[who].deck[(int)rack[rackp]] |= 128;
-		    return hand[who].deck[i] & 63;
-		}
-		else rackp--;
-	    }
-	}
-	else 
-	{
-	    rank = hand[who].deck[i]/4; rackp = 1; rack[0] = i;
-	}
-	i++;
-    }    
-    return 0;
-}
-
-static int lookfor1(int who, int betterthis)
-{
-    int i = 0;
-
-/*  wmove(stdscr, 1,50);
-    messageline("debug line in lookfor1");
-    getch(); */
+    int deck[NUMCARDS];
 
-    sortcard(who);
-    if (hand[who].held == 0) return 0;
-    while (i < hand[who].held)
-    {
-	if (((hand[who].deck[i] & 63) + 1) > betterthis)
-	{
-	    hand[who].deck[i] |= 128;
-	    return (hand[who].deck[i] & 63) + 1;
-	}
-	i++;
-    }    
-    return 0;
+    if ((pos < 0) || (pos >= showorder(who, deck))) return 0;
+    return deck[pos];
 }
 
-static void dropcard(int *whatcard, int who)
+static void drawhand(int aty, int who)
 {
-    int crd, i;
-    
-    crd = hand[who].deck[*whatcard] & 63;
-    for (i = *whatcard; i < hand[who].held - 1; i++)
-    {
-	hand[who].deck[i] = hand[who].deck[i + 1];
-    }
-    if (*whatcard >= --hand[who].held) (*whatcard)--;
-    if (!hand[who].held) (*whatcard)++;
-    hand[MAXPLAYERS + 1].deck[hand[MAXPLAYERS + 1].held++] = crd;
-    hand[MAXPLAYERS].deck[hand[MAXPLAYERS].held++] = crd;    
-}
+    int i, n, deck[NUMCARDS];
 
-static void dropcard2(int *whatcard, int who)
-{
-    int crd, i;
-    
-    crd = hand[who].deck[*whatcard] & 63;
-    for (i = *whatcard; i < hand[who].held - 1; i++)
-    {
-	hand[who].deck[i] = hand[who].deck[i + 1];
-    }
-    if (*whatcard >= --hand[who].held) (*whatcard)--;
-    if (!hand[who].held) (*whatcard)++;
-    hand[MAXPLAYERS + 2].deck[hand[MAXPLAYERS + 2].held++] = crd;
+    n = showorder(who, deck);
+    for (i = 0; i < n; i++)
+	drawcard(aty, i*3, deck[i] | (cardlevel(who, deck[i]) << 6));
 }
 
-/* call this when really ready to drop a combo... after validations etc. */
-static void dropcombo(int who)
+/* the cards raised to the same level as the cursor card, leaving the cursor
+where it will be once they are thrown */
+static cardmask pickcombo(int *cardx)
 {
-    int i;
-
-    hand[MAXPLAYERS + 1].held = 0;
-    i = 0;
-    while (i < hand[who].held)
-    {
-	if (hand[who].deck[i] & 128) dropcard(&i, who);
-	else i++;
-    }
+    cardmask combo;
+    int i, level, left;
+
+    level = cardlevel(thisplayer, cardat(thisplayer, *cardx));
+    combo = levelcards(thisplayer, level);
+    for (*cardx = 0, i = 0; i < level; i++)
+	*cardx += popcount(levelcards(thisplayer, i));
+    left = game.hand[thisplayer].held - popcount(combo);
+    if ((*cardx >= left) && *cardx) *cardx = left - 1;
+    return combo;
 }
 
-static int makechoice(int who, int firstdrop, int betterthis)
-{
-    int i, stry, sbetter; /* stry and sbetter used when searching for 
-	combo that contains the lowest card--for the very first throw */
-
-    if (firstdrop == 2)
-    {
-	if (betterthis) stry = hand[MAXPLAYERS + 1].held;
-	else stry = 5;
-	sbetter = betterthis;
-	while (stry > 0)
-	{
-	    do
-	    {
-		switch (stry)
-		{
-		    case 5:
-			sbetter = lookfor5(who, sbetter);
-			break;
-		    case 3:
-			sbetter = lookfor3(who, sbetter);
-			break;
-		    case 2:
-			sbetter = lookfor2(who, sbetter);
-			break;
-		    case 1:
-			sbetter = lookfor1(who, sbetter);
-			break;
-		    default:
-			fatal("stry set to invalid value in makechoice");
-		}
-		if (sbetter)
-		{
-		    for (i = 0; i < hand[who].held; i++) if 
-			((unsigned)hand[who].deck[i] == 128) 
-			return sbetter;
-		    for (i = 0; i < hand[who].held; i++)
-			hand[who].deck[i] &= 63;    
-		}
-	    }
-	    while (sbetter > 0);
-	    if (--stry == 4) stry--;
-	}
-	/* the following should only be taken only when makechoice is used
-	to validate user's throw and user did not use the lowest three */
-	return 0;
-    }
-    if (firstdrop)
-    {
-	if (betterthis) stry = hand[MAXPLAYERS + 1].held;
-	else stry = 5;
-	sbetter = betterthis;
-	while (stry > 0)
-	{
-	    do
-	    {
-		switch (stry)
-		{
-		    case 5:
-			sbetter = lookfor5(who, sbetter);
-			break;
-		    case 3:
-			sbetter = lookfor3(who, sbetter);
-			break;
-		    case 2:
-			sbetter = lookfor2(who, sbetter);
-			break;
-		    case 1:
-			sbetter = lookfor1(who, sbetter);
-			break;
-		    default:
-			fatal("stry set to invalid value in makechoice");
-		}
-		if (sbetter) return sbetter;
-	    }
-	    while (sbetter > 0);
-	    if (--stry == 4) stry--;
-	}
-	fatal("no choice found for first throw.");
-    }
-    switch (hand[MAXPLAYERS + 1].held)
-    {
-	case 5:
-	    return lookfor5(who, betterthis);
-	case 3:
-	    return lookfor3(who, betterthis);
-	case 2:
-	    return lookfor2(who, betterthis);
-	case 1:
-	    return lookfor1(who, betterthis);
-	default:
-	    fatal("internal error 2 in makechoice().\n");
-    }
-    return 0;
-}
-
-#ifdef nothing
-static void movemark(int who, int from, int to)
-{
-    int i;
-    for (i = 0; i < hand[who].held; i++)
-	if ((hand[who].deck[i] & 63) == from) break;
-    if (i == hand[who].held) fatal("from not found in movemark");
-    if (hand[who].deck[i] & 128) hand[who].deck[i] &= 63;
-    else fatal("movemark called on deck entry without mark");
-
-    for (i = 0; i < hand[who].held; i++)
-	if ((hand[who].deck[i] & 63) == to) break;
-    if (i == hand[who].held) fatal("to not found in movemark");
-    if (hand[who].deck[i] & 128) 
-	fatal("movemark called for entry with mark");
-    else hand[who].deck[i] |= 128;
-}
-
-static int checkchoice(int who, int firstdrop, int betterthis)
+#ifdef SHOWCARDS
+static void printcards(cardmask m)
 {
-    typedef struct {
-	int c
-	int crd[4];	/* encodes position in deck */
-    } planstruct[13];
-    planstruct plan, planbak;
-    int i, j, k, l, m, n, choice, heldsave, tryout, conflict, reconcile = 1;
-    int straight[13][5], straights; /* essential straights */
-    int flush[13][5], flushes; /* essential flushes and strflsh... */
-    int savebetter;
-
-    for (i = 0; i < 13; i++)
-    {
-	plan[i].cnt = 0;
-	for (j = 0; j < 4; j++) plan[i].crd[j] = 128;
-    }
-
-    for (i = 0; i < hand[who].deck; i++)
-    {
-	j = hand[who].deck[i];
-	plan[j/13].crd[j%4] = i;
-    }
-
-    heldsave = hand[MAXPLAYERS + 1].held;
-    hand[MAXPLAYERS + 1].held = 5;
-    tryout = 0;
-    while (tryout = makechoice(who, 0, tryout))	/* inspect 5 card combos */
-    {
-	/* if (tryout < isstraightflush(who)) continue; */
-	/* Do not ignore straight flush/royal flush--treat them as if
-	   straight / flush for now */
-	conflict = 0; planbak = plan;
-	for (i = 0; i < hand[who].held; i++) 
-	    if ((hand[who].deck[i] & 128) && (conflict < 8))
-	{
-	    j = hand[who].deck[i] & 63;
-            if (plan[j/13].crd[j%4] & 32)
-	    {
-		for (k = 0; k < 4; k++) if ((plan[j/13].crd[k] != 128) &&
-		    (k != j % 4)) /* look at all cards see if conflict */
-		{ 		  /* with a straight may be remedied */
-/* remedy by     */ if ((plan[j/13].crd[k] & (32 + 64)) == 0)
-/* choosing ano- */ {
-/* ther card of  */	plan[j/13].crd[k] |= 32;
-/* the same rank */     plan[j/13].crd[j % 4] &= 31;
-			movemark(who, j, (j/13)*13 + k);
-		    }
-		}
-		if (k == 4) conflict+=15;
-	    }
-/* possible improvement:  straight up/down shifting but this may not be
-effective since we are scanning for all choices anyway */
-		
-            if (plan[j/13].crd[j%4] & 64)
-	    { /* try to fix conflict with a flush */
-		for (k = 0; k < 13; k++) if ((plan[k].crd[j%4] != 128) &&
-		(k != (j/13)) && (plan[k].crd[j%4] & (32 + 64)) == 0))
-		{
-		    plan[k].crd[j % 4] |= 64;
-		    plan[k].crd[j % 4] &= 63;
-		    movemark(who, j, k*13 + j%4);	
-		}
-		if (k == 13) conflict+=15;
-		else j = k*13 + j % 4;
-	    }
-	    /*  this way of conflict counting allows us to deduct conflict
-		count for claimed areas */
-	    for (m = 0; m < 4; m++)
-		if ((plan[j/13].crd[m] & 31) && !(plan[j/13].crd[m] & 96))
-		    conflict++;
-            if (conflict > = 8) plan = planbak;
-	}
-
-	if (conflict < 8)	/* if there are few conflicts--only 2 */
-	{
-	    l = 0;
-	    for (i = 0; i < hand[who].held; i++) if (hand[who].deck[i] & 128)
-	    {
-		j = hand[who].deck[i] & 63;
-	        /* is it a striaght */
-		if (tryout < 41)
-		{
-		    straight[straights][l++] = i;
-		    plan[j/13].crd[j%4] |= 32;
-		    if (l == 5) staaights++;
-		}
-		else if ((tryout > 40) && (tryout < 73))
-		{
-		    flush[flushes][l++] = i;
-		    plan[j/13].crd[j%4] |= 64;
-		    if (l == 5) flushes++;
-		}
-		else fatal("unhandled 5 card combo passed in checkchoice");
-	    }
-	}
-	for (i = 0; i < hand[who].held; i++) hand[who].deck[i] &= 63;
-    }
-
-    if (firstdrop)
-    {
-	hand[MAXPLAYERS + 1].held = 5; betterthis = 0;
-    }
-    else hand[MAXPLAYERS + 1].held = heldsave;
-
-    while (betterthis = makechoice(int who, int firstdrop, int betterthis)
-    {
-	savebetter = betterthis;
-	conflict = 1;
-	if (betterthis < isstraightflush(who)) continue;
-	j = 0;
-	for (i = 0; i<hand[who].held; i++) if (hand[who].deck[i] & 128) j++;
-
-/* j */	switch (j)
-	{
-	    case 5:
-		if ((betterthis < 41) || (betterthis > 98))
-		{
-/* i */		    for (i = 0; i<hand[who].held; i++)
-		        if (hand[who].deck[i] & 128)	/* for each card */
-		    {
-/* m */		    	m = hand[who].deck[i] & 63;
-			break;
-		    } /* m has first card */
-		    for (l = 0; l < straights; l++)
-			if (straight[l][0] == (m / 13)) 
-		    {
-			conflict = 0; break;
-		    }
-		    if ((!conflict) && (betterthis > 98)) return betterthis;
-		    if (!conflict)	/* is the straight essential? */
-		    {
-		        for (n = 0; n < hand[who].held; n++)
-			{
-			    if (hand[who].deck[n] & 128) 
-				m = hand[who].deck[n] & 63;
-			    hand[who].deck[n] &= 63;
-			}
-			for (n = 0; n < 5; n++)
-			{
-
-/* code should now be able to intelligently handle beat condition when
-plan dictates otherwise for a straight */
-			    i = hand[who].deck[ straight[l][n] ];
-			    betterthis = 
-				tlate(i) - 15;
-			    hand[who].deck[ straight[l][n] ] |= 128;
-			
-			}
-			if (betterthis >= savebetter) return betterthis;
-			else
-			{
-			    if (!(plan[m/13].crd[m%4] & (32 + 64))
-				&& (plan[m/13].crd[m%4] == 128))
-			    {
-				movemark(who, i, m);
-				return savebetter;
-			    }
-			    betterthis = savebetter;
-			}
-		    }
-		} 
-		else if (betterthis < 73)
-		{
-		    conflict = 0; planbak = plan;
-		    for (i = 0; i < hand[who].held; i++) 
-	    	    if ((hand[who].deck[i] & 128) && (conflict < 8))
-		    {
-	    j = hand[who].deck[i] & 63;
-            if (plan[j/13].crd[j%4] & 32)
-	    {
-		for (k = 0; k < 4; k++) if ((plan[j/13].crd[k] != 128) &&
-		    (k != j % 4)) /* look at all cards see if conflict */
-		{ 		  /* with a straight may be remedied */
-/* remedy by     */ if ((plan[j/13].crd[k] & (32 + 64)) == 0)
-/* choosing ano- */ {
-/* ther card of  */	plan[j/13].crd[k] |= 32;
-/* the same rank */     plan[j/13].crd[j % 4] &= 31;
-			movemark(who, j, (j/13)*13 + k);
-		    }
-		}
-		if (k == 4) conflict+=15;
-	    }
-/* possible improvement:  straight up/down shifting but this may not be
-effective since we are scanning for all choices anyway */
-		
-            if (plan[j/13].crd[j%4] & 64)
-	    { /* try to fix conflict with a flush */
-		for (k = 0; k < 13; k++) if ((plan[k].crd[j%4] != 128) &&
-		(k != (j/13)) && (plan[k].crd[j%4] & (32 + 64)) == 0))
-		{
-		    plan[k].crd[j % 4] |= 64;
-		    plan[k].crd[j % 4] &= 63;
-		    movemark(who, j, k*13 + j%4);	
-		}
-		if (k == 13) conflict+=15;
-		else j = k*13 + j % 4;
-	    }
-	    /*  this way of conflict counting allows us to deduct conflict
-		count for claimed areas */
-	    for (m = 0; m < 4; m++)
-		if ((plan[j/13].crd[m] & 31) && !(plan[j/13].crd[m] & 96))
-		    conflict++;
-            if (conflict > = 8) plan = planbak;
-	}
-
-	if (conflict < 8)	/* if there are few conflicts--only 2 */
-	{
-	    l = 0;
-	    for (i = 0; i < hand[who].held; i++) if (hand[who].deck[i] & 128)
-	    {
-		j = hand[who].deck[i] & 63;
-	        /* is it a striaght */
-		if (tryout < 41)
-		{
-		    straight[straights][l++] = i;
-		    plan[j/13].crd[j%4] |= 32;
-		    if (l == 5) staaights++;
-		}
-		else if ((tryout > 40) && (tryout < 73))
-		{
-		    flush[flushes][l++] = i;
-		    plan[j/13].crd[j%4] |= 64;
-		    if (l == 5) flushes++;
-		}
-		else fatal("unhandled 5 card combo passed in checkchoice");
-	    }
-	}
-	for (i = 0; i < hand[who].held; i++) hand[who].deck[i] &= 63;
+    int i, n, deck[NUMCARDS];
 
-		}
-	        break;
-	    case 4:
-		fatal("makechoice returned 4 cards for checkchoice");
-	    case 3:
-	        break;
-	    case 2:
-		
-	        break;
-	    case 1:
-	        break;
-	}
-	for (i = 0; i < hand[who].held; i++) hand[who].deck[i] &= 63;
-    }
+    n = maskcards(m, deck);
+    for (i = 0; i < n; i++) printw("%c%c ", ranks[deck[i]/4], suits[deck[i]%4]);
 }
 #endif
 
-static int onewon(void)
+static int askyn(char *s)
 {
-    int i;
+    int ch;
 
-    for (i = 0; i < numplayers; i++) if (!hand[i].held) 
+    messageline(s);
+    do
     {
-	hand[i].held = 60; return i + 1; /* set held to 60 when one wins */
+ 	beep();
+	ch = toupper(getch());
     }
-    return 0;
-}
-
-static int onehaslost(void)
-{
-    int i, k = 0;
-
-    for (i = 0; i < numplayers; i++)
-	if (hand[i].held != 60) k++;
-    return k == 1;
+    while ((ch != 'Y') && (ch != 'N'));
+    return (ch == 'Y');
 }
 
-static int validate(int firstdrop, int betterthis)
+/* puts the turn state the game loops keep into game */
+static void setturn(int who, int firstdrop, comboval betterthis, 
+    int lastthrow, int cntrlflag)
 {
-    int i, j, k = 0;
-
-    if ((i = makechoice(MAXPLAYERS + 2, firstdrop, betterthis))) 
-    {
-	if ((j = isstraightflush(MAXPLAYERS + 2))) i = j;
-	for (j = 0; j < hand[MAXPLAYERS + 2].held; j++)
-	    if (hand[MAXPLAYERS + 2].deck[k] & 128) k++;
-	if (k == hand[MAXPLAYERS + 2].held)
-	{
-	    j = 0;
-	    hand[MAXPLAYERS + 1].held = 0;
-	    while ((j < hand[MAXPLAYERS + 2].held) && (hand[MAXPLAYERS + 
-		2].held)) dropcard(&j, MAXPLAYERS + 2);
-	    return i;
-	}
-    }
-    hand[thisplayer] = hand[MAXPLAYERS + 3];
-    return 0;
+    game.turn = who;
+    game.firstdrop = firstdrop;
+    game.betterthis = betterthis;
+    game.lastthrow = lastthrow;
+    game.cntrlflag = cntrlflag;
 }
 
-static void nextsuitscombi()
+/* a key from the player whose turn it is, the computer players pondering
+on their trees in the meantime, each from where it sees the game now.
+they are stopped before the key is given back, so game is theirs again */
+static int pondergetch(int who, int firstdrop, comboval betterthis,
+    int lastthrow, int cntrlflag)
 {
-    int i = 3, j = 3, k; 
-    if ((suits[3] < suits[2]) && (suits[2] < suits[1]) && (suits[1] < suits[0]))
-    {
-	strcpy(suits, "CDHS"); return;
-    }
-    if (suits[2] < suits[3])
-    {
-	i = suits[3]; suits[3] = suits[2]; suits[2] = i; return;
-    }
-    while (suits[i - 1] > suits[i]) i--;
-    while (suits[j] < suits[i - 1]) j--;
-    k = suits[j]; suits[j] = suits[i - 1]; suits[i - 1] = k;
-    qsort(&suits[i], 4 - i, sizeof(suits[0]), mycompar);
+    double deadline = wallclock() + PONDERTIME / 1000.0;
+    int i, key;
+
+    setturn(who, firstdrop, betterthis, lastthrow, cntrlflag);
+    for (i = 0; i < game.numplayers; i++)
+	if (i != who) startponder(&game, &searcher[i], i, deadline);
+    key = getch();
+    for (i = 0; i < game.numplayers; i++) stopponder(&searcher[i]);
+    return key;
 }
 
-/* called when a successful combo is found */
-static int reportcombo(int j, char *mes, char *whos)
+/* the choice of computer player who, which takes thinktime ms whenever it
+is made.  the searching player plays the game out from where it stands,
+so it gets the turn state the game loops keep, and it takes up its tree 
+from its last turn where it can.  an ending it can see all of it plays 
+exactly, if it can work it out in the first half of the time;  else the
+search has the rest */
+static comboval computerchoice(int who, int firstdrop, comboval betterthis,
+    int lastthrow, int cntrlflag, cardmask *pick)
 {
-    int k;
+    double start = wallclock(), deadline = start + thinktime / 1000.0, left;
+    comboval v;
 
-    switch (hand[MAXPLAYERS + 1].held)
+    setturn(who, firstdrop, betterthis, lastthrow, cntrlflag);
+    if (solver.slot && solvable(&game, ENDGAME) && 
+	(solve(&game, &solver, start + thinktime / 2000.0, pick) >= 0))
     {
-	case 1:
-            sprintf(mes, "%s threw a single card (%d).", whos, j);
-	    break;
-	case 2:
-	    sprintf(mes, "%s threw a pair (%d).", whos, j);
-	    break;
-	case 3:
-	    sprintf(mes, "%s threw a trio (%d).", whos, j);
-	    break;
-	case 5:
-	    if (j < 41)
-	    {
-		if ((k = isstraightflush(MAXPLAYERS + 1)) > 135) sprintf(mes, 
-		    "That was just a royal flush (%d)", k);
-		else if (k) sprintf(mes, "That was a straight flush (%d)", k);
-		else sprintf(mes, "%s threw a straight (%d).", whos, j);
-		if (k) j = k;
-	    }
-	    else if (j < 73)
-	    {
-		if ((k = isstraightflush(MAXPLAYERS + 1)) > 134) sprintf(mes, 
-		    "That was just a royal flush (%d)", k);
-		else if (k) sprintf(mes, "That was a straight flush (%d)", k);
-		else sprintf(mes, "%s threw a flush (%d).", whos, j);
-		if (k) j = k;
-	    }
-	    else if (j < 86) sprintf(mes, 
-		"%s threw a full house (%d).", whos, j);
-	    else if (j < 99) sprintf(mes,
-		"%s threw a four of a kind (%d).", whos, j);
-	    break;
-    }
-    return j;
-}
-
-static void setbit1(int *val, int bit, int set)
-{
-    if (set) *val |= (1 << bit);
-    else *val &= ~(1 << bit);
-}
-
-static int askyn(char *s)
-{
-    int ch;
-
-    messageline(s);
-    do
-    {
- 	beep();
-	ch = toupper(getch());
+#ifdef DEBUGGING
+	fprintf(fdbg, "ending solved in %lu positions, %.0f a second\n",
+	    solver.nodes, solver.secs > 0 ? solver.nodes / solver.secs : 0.0);
+#endif
+	v = *pick ? playvalue(*pick) : 0;
     }
-    while ((ch != 'Y') && (ch != 'N'));
-    return (ch == 'Y');
+    else v = ismcts(&game, &searcher[who], INT_MAX, deadline, pick);
+    if ((left = deadline - wallclock()) > 0) usleep(left * 1e6);
+    return v;
 }
 
 static void playgame()
 {
-    int i, j, k, key, choice = 0, cardx = 0, betterthis = 0, lastthrow = 100;
+    int i, j, k, key, choice = 0, cardx = 0, lastthrow = 100;
     int redraw = 1, turn, firstdrop = 2, cntrlflag = 0, woncount = 1;
     WINDOW *win;
     char mes[80], mes2[30];
-    int wonarray[4];
+    int wonarray[4], crd;
+    cardmask pick;
+    comboval betterthis = 0;
 #ifndef SHOWCARDS
     char *orders[] = {"first", "second", "third", "fourth"};
 #endif
 
-    shuffle();
+    shuffle(&game);
+    inittracker(&tracker);
+#ifdef DEBUGGING
+    for (i = 0; i < 4; i++) handdebug[i] = game.hand[i];
+#endif
 
 #ifdef DEBUGGING
     fputs("Start of a new game\n", fdbg);
 #endif
-    turn = whosfirst();
+    turn = whosfirst(&game);
 
     leaveok(stdscr, FALSE);
     clear();
-    for (i = 0; i < hand[thisplayer].held; i++) 
-        drawcard(15,i*3,hand[thisplayer].deck[i]);
+    lift[0] = lift[1] = 0;
+    drawhand(15, thisplayer);
     do
     {
 	
 	key = 1;
 #ifdef SHOWCARDS
 	wmove(stdscr, 9, 0);
-	for (j = 1; j < numplayers; j++) if (hand[j].held != 60)
+	for (j = 1; j < game.numplayers; j++) if (game.hand[j].held != 60)
 	{
 	    printw("%d:",j);
-            for (i = 0; i < hand[j].held; i++) printw("%c%c ",
-	        ranks[hand[j].deck[i]/4], suits[hand[j].deck[i]%4]); 
+	    printcards(game.hand[j].cards);
             printw("       \n");
         } else printw("         \n");
 
 	wmove(stdscr, 8, 0);printw("lastthrown: ");
-            for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) printw("%c%c ",
-	        ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-		suits[hand[MAXPLAYERS + 1].deck[i]%4]); 
+	    printcards(game.hand[MAXPLAYERS + 1].cards);
 	refresh();
 #else
 	wmove(stdscr, 8, 0);
@@ -1862,16 +595,16 @@ static void playgame()
 
         /* MARK_1 */
 
-	for (j = 0; j < numplayers; j++)
+	for (j = 0; j < game.numplayers; j++)
 	{
 	    wmove(stdscr, j + 8, 38);
-	    if (hand[j].held != 60) 
+	    if (game.hand[j].held != 60) 
 	    {
 		if (dispvar) {
 		    if (j == thisplayer) 
-		    printw("You have %d card(s)", hand[j].held);
+		    printw("You have %d card(s)", game.hand[j].held);
 		    else
-		    printw("%s has %d card(s)", messagerec[j].name, hand[j].held);
+		    printw("%s has %d card(s)", messagerec[j].name, game.hand[j].held);
 
 		}
 	    }
@@ -1895,8 +628,8 @@ static void playgame()
 
 	    sprintf(mes, "It is now Computer player %d's turn.", turn);
 	    messageline(mes);
-	    sleep(1);
-	    if ((j = makechoice(turn, firstdrop, betterthis)) == 0)
+	    if ((j = computerchoice(turn, firstdrop, betterthis, lastthrow,
+		cntrlflag, &pick)) == 0)
 	    {
 #ifdef DEBUGGING
 		fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
@@ -1906,6 +639,7 @@ static void playgame()
 	    	fprintf(fdbg, "redraw %d\n", redraw);
 	    	fprintf(fdbg, "Computer player %d passed.", turn);
 #endif
+		trackpass(&tracker, turn, firstdrop ? 0 : betterthis);
 	    	if (cntrlflag)
 	    	{
 		    lastthrow = turn;
@@ -1916,9 +650,9 @@ static void playgame()
 	    }
 	    else
 	    {
-		dropcombo(turn);
+		dropcombo(&game, turn, pick);
 		sprintf(mes2, "Computer player %d", turn);
-		betterthis = reportcombo(j, mes, mes2);
+		betterthis = reportcombo(&game, mes, mes2);
 
 #ifdef DEBUGGING
 		fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
@@ -1927,11 +661,8 @@ static void playgame()
 	    	fprintf(fdbg, "betterthis %d\n", betterthis);
 	    	fprintf(fdbg, "redraw %d\n", redraw);
 	    	fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
-	    	fprintf(fdbg, "number of thrown cards %d\n", hand[MAXPLAYERS + 1].held);
-	    	for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	            fprintf(fdbg, "%d %c%c\n", hand[MAXPLAYERS + 1].deck[i],
-	            ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	            suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+		fprintf(fdbg, "number of thrown cards %d\n", game.hand[MAXPLAYERS + 1].held);
+		logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 	    	if (cntrlflag)
 	    	{
@@ -1941,7 +672,7 @@ static void playgame()
 		lastthrow = turn; firstdrop = 0; messageline(mes);
 		redraw = 3;
 	    }
-    	    while (hand[turn = (turn + 1) % numplayers].held == 60);
+	    while (game.hand[turn = (turn + 1) % game.numplayers].held == 60);
 	}
 	else
 	{
@@ -1981,47 +712,32 @@ static void playgame()
 
 	    wmove(stdscr, 16, cardx*3);
 	    refresh();
-            switch (key = getch())
+	    switch (key = pondergetch(turn, firstdrop, betterthis, lastthrow,
+		cntrlflag))
 	    {
 	    	case ' ':
 		case 13:
 		    if (choice == 4)
 		    {
-			for (k = 0; k < hand[turn].held; k++)
-			   hand[turn].deck[k] &= 63;
-			sortcard(turn); redraw = 1; break;
+			lift[0] = lift[1] = 0;
+			redraw = 1; break;
 		    } else if (choice == 5)
 		    {
-			for (k = 0; k < hand[turn].held; k++)
-			{
-			    switch ((hand[turn].deck[k] & 63) % 4)
-			    {
-				case 0:
-				    setbit1(&hand[turn].deck[k], 6, 0);
-				    setbit1(&hand[turn].deck[k], 7, 0); break;
-				case 1:
-				    setbit1(&hand[turn].deck[k], 6, 1);
-				    setbit1(&hand[turn].deck[k], 7, 0); break;
-				case 2:
-				    setbit1(&hand[turn].deck[k], 6, 0);
-				    setbit1(&hand[turn].deck[k], 7, 1); break;
-				case 3:
-				    setbit1(&hand[turn].deck[k], 6, 1);
-				    setbit1(&hand[turn].deck[k], 7, 1); break;
-			    }
-			}
-			sortcard(turn); redraw = 1; break;
+			lift[0] = game.hand[turn].cards & 
+			    (SUITCARDS(1) | SUITCARDS(3));
+			lift[1] = game.hand[turn].cards & 
+			    (SUITCARDS(2) | SUITCARDS(3));
+			redraw = 1; break;
 		    } else if (choice == 1)
 		    {
-			if (firstdrop || (hand[MAXPLAYERS + 1].held == 1)) 
+			if (firstdrop || (game.hand[MAXPLAYERS + 1].held == 1)) 
 			{
-			    if ((((hand[turn].deck[cardx] & 63) + 1) 
-				> betterthis) || firstdrop)
+			    crd = cardat(thisplayer, cardx);
+			    if ((j = validate(&game, thisplayer, firstdrop, 
+				betterthis, CARDBIT(crd))))
 			    {
-				betterthis = (hand[turn].deck[cardx] & 63)
-				    + 1;
-			        hand[MAXPLAYERS + 1].held = 0;
-		    	    	dropcard(&cardx, thisplayer);
+				betterthis = j;
+				if ((cardx >= game.hand[thisplayer].held) && cardx) cardx--;
 
 #ifdef DEBUGGING
 				fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
@@ -2031,12 +747,8 @@ static void playgame()
 	    			fprintf(fdbg, "redraw %d\n", redraw);
 	    			fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    			fprintf(fdbg, "number of thrown cards %d\n",
-				    hand[MAXPLAYERS + 1].held);
-	    			for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	        		    fprintf(fdbg, "%d %c%c\n", 
-				    hand[MAXPLAYERS + 1].deck[i],
-	        		    ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	        		    suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+				    game.hand[MAXPLAYERS + 1].held);
+				logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 			    	if (cntrlflag)
 			    	{
@@ -2046,9 +758,11 @@ static void playgame()
 		    	    	messageline("you have dropped a single card");
 	             		lastthrow = turn;
 			    	firstdrop = 0;
-		   		while (hand[turn = (turn + 1) % 
-				    numplayers].held == 60);
+				while (game.hand[turn = (turn + 1) % 
+				    game.numplayers].held == 60);
 			    }
+			    else if (firstdrop == 2) 
+				messageline("the first throw must hold the 3D");
 			    else messageline("your card is too low");
 			}
 			else messageline("you may not drop a single card!!!");
@@ -2067,37 +781,24 @@ static void playgame()
 	    		    fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    		    fprintf(fdbg, "user has passed.");
 #endif
+			    trackpass(&tracker, turn, firstdrop ? 0 : betterthis);
 			    if (cntrlflag)
 			    {
 				lastthrow = turn;
 				cntrlflag--;
 			    }
-	   		    while (hand[turn = (turn + 1) % 
-			       numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+			       game.numplayers].held == 60);
 			    if (firstdrop == 2) firstdrop--;
 		        }
 		    }
 		    else if (choice == 0)
 		    { 
 			k = cardx;
-			hand[MAXPLAYERS + 2].held = 0;
-			hand[MAXPLAYERS + 3] = hand[thisplayer];
-		    	i = hand[thisplayer].deck[cardx] >> 6;
-		    	j = 0;
-		    	while ((j < hand[thisplayer].held) && 
-			    (hand[thisplayer].held))
-		        {
-			    if (i == (hand[thisplayer].deck[j] >> 6))
-			    {
-		            	dropcard2(&j, thisplayer);
-			    	cardx = j;
-			    }
-			    else j++;
-		    	} /* this transfers selected cards to 
-			hand[MAXPLAYERS + 2] */
-			if ((j = validate(firstdrop, betterthis)))
+			if ((j = validate(&game, thisplayer, firstdrop, betterthis,
+			    pickcombo(&cardx))))
 			{
-			    betterthis = reportcombo(j, mes, name);
+			    betterthis = reportcombo(&game, mes, name);
 
 #ifdef DEBUGGING
 			    fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
@@ -2107,12 +808,8 @@ static void playgame()
 			    fprintf(fdbg, "redraw %d\n", redraw);
 			    fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    		    fprintf(fdbg, "number of thrown cards %d\n",
-				hand[MAXPLAYERS + 1].held);
-	    		    for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	        	    fprintf(fdbg, "%d %c%c\n",
-				hand[MAXPLAYERS + 1].deck[i],
-	        		ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	        		suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+				game.hand[MAXPLAYERS + 1].held);
+			    logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 			    if (cntrlflag)
 			    {
@@ -2122,8 +819,8 @@ static void playgame()
 			    messageline(mes);
              		    lastthrow = turn;
 			    firstdrop = 0;
-			    while (hand[turn = (turn + 1) % 
-				numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+				game.numplayers].held == 60);
 		        }
 			else 
 			{
@@ -2149,7 +846,7 @@ static void playgame()
 	    	case '4': 
             	    if (cardx > 0) cardx--; break;
 	    	case '6':
-            	    if (cardx < hand[thisplayer].held - 1) cardx++; break;
+		    if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 		case 27:
 	            if ((key = getch()) != 91)
 		    {
@@ -2161,36 +858,37 @@ static void playgame()
                         case 54:
                             if (getch() == 126)
 			    {
+				crd = cardat(thisplayer, cardx);
 			    	if (key == 53)
 			    	{
-				    if (hand[thisplayer].deck[cardx] & 64) 
+				    if (lift[0] & CARDBIT(crd)) 
 				    {
-				        if (!(hand[thisplayer].deck[cardx] & 128))
+					if (!(lift[1] & CARDBIT(crd)))
  				    	{
-					    hand[thisplayer].deck[cardx] |= 128;
-					    hand[thisplayer].deck[cardx] &= 191;
+					    lift[1] |= CARDBIT(crd);
+					    lift[0] &= ~CARDBIT(crd);
 					    redraw = 1;
 				        }
 				    }
 				    else 
 				    {
-				    	hand[thisplayer].deck[cardx] |= 64;
+					lift[0] |= CARDBIT(crd);
 				        redraw = 1;
 				    }
 			    	}
 			        else
 			    	{
-				    if (hand[thisplayer].deck[cardx] & 64) 
+				    if (lift[0] & CARDBIT(crd)) 
 				    {
 				    	redraw = 1;
-				    	hand[thisplayer].deck[cardx] &= 191;
+					lift[0] &= ~CARDBIT(crd);
 				    }
 				    else 
-				    if (hand[thisplayer].deck[cardx] & 128) 
+				    if (lift[1] & CARDBIT(crd)) 
 				    {
 				    	redraw = 1;
-				    	hand[thisplayer].deck[cardx] |= 64;
-				    	hand[thisplayer].deck[cardx] &= 127;
+					lift[0] |= CARDBIT(crd);
+					lift[1] &= ~CARDBIT(crd);
 				    }
 			    	}
 			    }
@@ -2204,7 +902,7 @@ static void playgame()
 		    	case 68: 
         	    	    if (cardx > 0) cardx--; break;
 		    	case 67:
-            		    if (cardx < hand[thisplayer].held - 1) cardx++; break;
+			    if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 		    	default:
 			    beep(); continue;
 		    }
@@ -2219,8 +917,7 @@ static void playgame()
 	    win = newwin(7,25,0,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) 
-                drawcard(0,i*3,hand[MAXPLAYERS + 1].deck[i]);
+	    drawhand(0, MAXPLAYERS + 1);
 	    if (redraw == 3) 
 	    {
 		refresh();
@@ -2231,16 +928,14 @@ static void playgame()
 	}
 	if (redraw)
 	{
-	    sortcard(thisplayer);
 	    win = newwin(10,80,12,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[thisplayer].held; i++) 
-                drawcard(15,i*3,hand[thisplayer].deck[i]);
+	    drawhand(15, thisplayer);
 	    redraw--;
 	}
 
-	if ((i = onewon()))
+	if ((i = onewon(&game)))
 	{
 	    wonarray[i-1] = woncount++;
 
@@ -2253,13 +948,13 @@ static void playgame()
 	    messageline(mes);
 	    firstdrop = 1;
 	    getch();
-	    if (!onehaslost() && controlmode)
+	    if (!onehaslost(&game) && game.controlmode)
 	    {
 		firstdrop = 0; cntrlflag = 1;
 	    } else betterthis = 0;
 	}
 
-    } while ((key != 0) && (!onehaslost()));
+    } while ((key != 0) && (!onehaslost(&game)));
 
 #ifndef SHOWCARDS
     wmove(stdscr, 8, 0);
@@ -2267,15 +962,15 @@ static void playgame()
     printw("  PgUp/PgDn - push a card up/down\n");
     printw("  left/right arrow - move cursor\n");
     printw("  Enter/Spacebar - do chosen action\n");
-    for (j = 0; j < numplayers; j++)
+    for (j = 0; j < game.numplayers; j++)
     {
         wmove(stdscr, j + 8, 38);
-	if (hand[j].held != 60) 
+	if (game.hand[j].held != 60) 
 	{
 	    if (j == thisplayer) 
-	    printw("You have lost holding %d card(s)", hand[j].held);
+	    printw("You have lost holding %d card(s)", game.hand[j].held);
 	    else
-	    printw("%s has lost with %d card(s)", messagerec[j].name, hand[j].held);
+	    printw("%s has lost with %d card(s)", messagerec[j].name, game.hand[j].held);
 	}
 	else
 	{
@@ -2390,12 +1085,12 @@ static void serv_send_message()
 
 static void playgameclient()
 {
-    int i, j, k, l, key, choice = 0, cardx = 0, betterthis = 0, lastthrow = 
-100;
+    int i, j, k, key, choice = 0, cardx = 0, lastthrow = 100;
     int redraw = 1, turn, firstdrop = 2, cntrlflag = 0, woncount = 1;
     WINDOW *win;
     char mes[80];
-    int wonarray[4];
+    int wonarray[4], crd;
+    comboval betterthis = 0;
 #ifndef SHOWCARDS
     char *orders[] = {"first", "second", "third", "fourth"};
 #endif
@@ -2404,10 +1099,7 @@ static void playgameclient()
     struct timeval tv;
     fd_set readfds;
 
-    hand[MAXPLAYERS].held = 0;
-    hand[MAXPLAYERS + 1].held = 0;
-    hand[MAXPLAYERS + 2].held = 0;
-    hand[MAXPLAYERS + 3].held = 0;
+    for (i = MAXPLAYERS; i < MAXPLAYERS + 2; i++) emptyhand(&game, i);
 
     registers = 0;
     do
@@ -2438,7 +1130,7 @@ static void playgameclient()
 		messagerec[registers] = messagebuf; 
 		if (messagebuf.pid == getpid()) 
 		    thisplayer = messagebuf.thisplayer;
-		hand[registers] = messagebuf.hand;
+		game.hand[registers] = messagebuf.hand;
 		sprintf(mes, "Player number %d is %s", registers + 1,
 		    messagebuf.name);
 		messageline(mes);
@@ -2482,13 +1174,13 @@ static void playgameclient()
 	    }
 	}
     }
-    while (registers < numplayers);
+    while (registers < game.numplayers);
 
-    turn = whosfirst();
+    turn = whosfirst(&game);
     send_setting = 4;
     clear();
-    for (i = 0; i < hand[thisplayer].held; i++) 
-        drawcard(15,i*3,hand[thisplayer].deck[i]);
+    lift[0] = lift[1] = 0;
+    drawhand(15, thisplayer);
     refresh();
     messageline("We are now ready to start the game at last.");
     do
@@ -2502,18 +1194,15 @@ static void playgameclient()
 	wmove(stdscr, 3, 40); printw("lastthrow %d", lastthrow);
 	
 	wmove(stdscr, 9, 0);
-	for (j = 0; j < numplayers; j++) if (hand[j].held != 60)
+	for (j = 0; j < game.numplayers; j++) if (game.hand[j].held != 60)
 	{
 	    printw("%d:",j);
-            for (i = 0; i < hand[j].held; i++) printw("%c%c ",
-	        ranks[hand[j].deck[i]/4], suits[hand[j].deck[i]%4]); 
+	    printcards(game.hand[j].cards);
             printw("       \n");
         } else printw("         \n");
 
 	wmove(stdscr, 8, 0);printw("lastthrown: ");
-            for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) printw("%c%c ",
-	        ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-		suits[hand[MAXPLAYERS + 1].deck[i]%4]); 
+	    printcards(game.hand[MAXPLAYERS + 1].cards);
 	refresh();
 #else
 	wmove(stdscr, 8, 0);
@@ -2521,17 +1210,17 @@ static void playgameclient()
         printw("  PgUp/PgDn - push a card up/down\n");
 	printw("  left/right arrow - move cursor\n");
         printw("  Enter/Spacebar - do chosen action\n");
-	for (j = 0; j < numplayers; j++)
+	for (j = 0; j < game.numplayers; j++)
 	{
 	    wmove(stdscr, j + 8, 38);
-	    if (hand[j].held != 60) 
+	    if (game.hand[j].held != 60) 
 	    {
 		if (dispvar) {
 		    if (j == thisplayer) 
-		    printw("You have %d card(s)", hand[j].held);
+		    printw("You have %d card(s)", game.hand[j].held);
 		    else
 		    printw("%s has %d card(s)", 
-		        messagerec[j].name, hand[j].held);
+			messagerec[j].name, game.hand[j].held);
 		}
 	    }
 	    else
@@ -2632,9 +1321,19 @@ static void playgameclient()
     	    } 
 	    else if (numbytes == sizeof(messagebuf)) 
 	    {
-		if (messagebuf.thisplayer == turn)
+		/* the throw is checked against the hand dealt, as the 
+		server checks it */
+		if ((messagebuf.thisplayer == turn) &&
+		    (messagebuf.betterthis != betterthis) &&
+		    !validate(&game, turn, firstdrop, betterthis,
+		    messagebuf.combo))
+		{
+		    sprintf(mes, "illegal throw by %s refused", 
+			messagebuf.name);
+		    messageline(mes);
+		}
+		else if (messagebuf.thisplayer == turn)
 		{
-		    hand[turn] = messagebuf.hand;
 		    if (messagebuf.betterthis == betterthis)
 		    {
 		        if (cntrlflag)
@@ -2647,9 +1346,7 @@ static void playgameclient()
     		    }
 		    else
 		    {
-			dropcombo(turn);
-			betterthis = reportcombo(messagebuf.betterthis,
-			    mes, messagebuf.name);
+			betterthis = reportcombo(&game, mes, messagebuf.name);
 
     			if (cntrlflag)
     			{
@@ -2660,8 +1357,8 @@ static void playgameclient()
 			messageline(mes);
 			redraw = 3;
     		    }
-    		    while (hand[turn = (turn + 1) % 
-			numplayers].held == 60);
+		    while (game.hand[turn = (turn + 1) % 
+			game.numplayers].held == 60);
 		    received = 1;
 		}
 		else
@@ -2717,50 +1414,32 @@ static void playgameclient()
 	    case 13:
 		if (choice == 4)
 		{
-		    for (k = 0; k < hand[thisplayer].held; k++)
-			hand[thisplayer].deck[k] &= 63;
-		    sortcard(thisplayer); redraw = 1; break;
+		    lift[0] = lift[1] = 0;
+		    redraw = 1; break;
 		} 
 		else if (choice == 5)
 		{
-		    for (k = 0; k < hand[thisplayer].held; k++)
-		    {
-		        switch ((hand[thisplayer].deck[k] & 63) % 4)
-			{
-			    case 0:
-				setbit1(&hand[thisplayer].deck[k], 6, 0);
-				setbit1(&hand[thisplayer].deck[k], 7, 0); break;
-			    case 1:
-				setbit1(&hand[thisplayer].deck[k], 6, 1);
-				setbit1(&hand[thisplayer].deck[k], 7, 0); break;
-			    case 2:
-				setbit1(&hand[thisplayer].deck[k], 6, 0);
-				setbit1(&hand[thisplayer].deck[k], 7, 1); break;
-			    case 3:
-				setbit1(&hand[thisplayer].deck[k], 6, 1);
-				setbit1(&hand[thisplayer].deck[k], 7, 1); break;
-			}
-		    }
-		    sortcard(thisplayer); redraw = 1; break;
+		    lift[0] = game.hand[thisplayer].cards & 
+			(SUITCARDS(1) | SUITCARDS(3));
+		    lift[1] = game.hand[thisplayer].cards & 
+			(SUITCARDS(2) | SUITCARDS(3));
+		    redraw = 1; break;
 		}
 		else if (choice == 1)
 		{
 		    if (turn == thisplayer)
 		    {
-		    	if (firstdrop || (hand[MAXPLAYERS + 1].held == 1)) 
+			if (firstdrop || (game.hand[MAXPLAYERS + 1].held == 1)) 
 			{
-			    if ((((hand[turn].deck[cardx] & 63) + 1) 
-			    > betterthis) || firstdrop)
+			    crd = cardat(thisplayer, cardx);
+			    messagebuf = messagerec[thisplayer];
+			    messagebuf.hand = game.hand[turn];
+			    if ((j = validate(&game, thisplayer, firstdrop, 
+				betterthis, CARDBIT(crd))))
 			    {
-				betterthis = (hand[turn].deck[cardx] & 63)
-				    + 1;
-			        hand[MAXPLAYERS + 1].held = 0;
-				messagebuf = messagerec[thisplayer];
-				messagebuf.hand = hand[turn];
-			        for (l = 0; l < hand[turn].held; l++)
-				    messagebuf.hand.deck[l] &= 63;
-				messagebuf.hand.deck[cardx] |= 128;
-		    	    	dropcard(&cardx, thisplayer);
+				betterthis = j;
+				messagebuf.combo = CARDBIT(crd);
+				if ((cardx >= game.hand[thisplayer].held) && cardx) cardx--;
 
 			        messagebuf.turn = turn;
 			        messagebuf.pid = getpid();
@@ -2778,9 +1457,11 @@ static void playgameclient()
 		    	    	messageline("you have dropped a single card");
 	             		lastthrow = turn;
 			    	firstdrop = 0;
-		   		while (hand[turn = (turn + 1) % 
-				    numplayers].held == 60);
+				while (game.hand[turn = (turn + 1) % 
+				    game.numplayers].held == 60);
 			    }
+			    else if (firstdrop == 2) 
+				messageline("the first throw must hold the 3D");
 			    else messageline("your card is too low");
 			}
 			else messageline("you may not drop a single card!!!");
@@ -2818,9 +1499,8 @@ static void playgameclient()
 			    messagebuf.turn = turn;
 			    messagebuf.firstdrop = firstdrop;
 			    messagebuf.betterthis = betterthis;
-			    messagebuf.hand = hand[turn];
-			    for (l = 0; l < hand[turn].held; l++)
-			        messagebuf.hand.deck[l] &= 63;
+			    messagebuf.hand = game.hand[turn];
+			    messagebuf.combo = 0;
 			    if (send(socketnum, (void *)&messagebuf, 
 		    	    	sizeof(messagebuf), 0) == -1) prerror("send");
 
@@ -2829,8 +1509,8 @@ static void playgameclient()
 				lastthrow = turn;
 				cntrlflag--;
 			    }
-	   		    while (hand[turn = (turn + 1) % 
-			       numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+			       game.numplayers].held == 60);
 			    if (firstdrop == 2) firstdrop--;
 		        }
 		    }
@@ -2858,38 +1538,18 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 		    if (turn == thisplayer)
 		    {
 			k = cardx;
-			hand[MAXPLAYERS + 2].held = 0;
-			hand[MAXPLAYERS + 3] = hand[thisplayer];
-		    	i = hand[thisplayer].deck[cardx] >> 6;
-		    	j = 0;
 
 			messagebuf = messagerec[thisplayer];
 			messagebuf.pid = getpid();
 			messagebuf.turn = turn;
 			messagebuf.thisplayer = thisplayer;
 			messagebuf.firstdrop = firstdrop;
-			messagebuf.hand = hand[turn];
-			for (l = 0; l < hand[turn].held; l++)
-			    messagebuf.hand.deck[l] &= 63;
-
-			l = j;
-		    	while ((j < hand[thisplayer].held) && 
-			    (hand[thisplayer].held))
-		        {
-			    if (i == (hand[thisplayer].deck[j] >> 6))
-			    {
-				messagebuf.hand.deck[l] |= 128;
-		            	dropcard2(&j, thisplayer);
-			    	cardx = j;
-			    }
-			    else j++;
-			    l++;
-		    	} 
-			/* this transfers selected cards to 
-			hand[MAXPLAYERS + 2] */
-			if ((j = validate(firstdrop, betterthis)))
+			messagebuf.hand = game.hand[turn];
+			messagebuf.combo = pickcombo(&cardx);
+			if ((j = validate(&game, thisplayer, firstdrop, betterthis,
+			    messagebuf.combo)))
 			{
-			    betterthis = reportcombo(j, mes, name);
+			    betterthis = reportcombo(&game, mes, name);
 
 			    messagebuf.betterthis = betterthis;
 			    while (send(socketnum, (void *)&messagebuf, 
@@ -2904,8 +1564,8 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 			    messageline(mes);
              		    lastthrow = turn;
 			    firstdrop = 0;
-			    while (hand[turn = (turn + 1) % 
-				numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+				game.numplayers].held == 60);
 		        }
 			else 
 			{
@@ -2935,7 +1595,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    case '4': 
                 if (cardx > 0) cardx--; break;
 	    case '6':
-                if (cardx < hand[thisplayer].held - 1) cardx++; break;
+		if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 	    case 27:
 	        if ((key = getch()) != 91)
 		{
@@ -2947,36 +1607,37 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
                     case 54:
                    	if (getch() == 126)
 			{
+			    crd = cardat(thisplayer, cardx);
 			    if (key == 53)
 			    {
-				if (hand[thisplayer].deck[cardx] & 64) 
+				if (lift[0] & CARDBIT(crd)) 
 				{
-				    if (!(hand[thisplayer].deck[cardx] & 128))
+				    if (!(lift[1] & CARDBIT(crd)))
  				    {
-					hand[thisplayer].deck[cardx] |= 128;
-					hand[thisplayer].deck[cardx] &= 191;
+					lift[1] |= CARDBIT(crd);
+					lift[0] &= ~CARDBIT(crd);
 					redraw = 1;
 				    }
 				}
 				else 
 				{
-				    hand[thisplayer].deck[cardx] |= 64;
+				    lift[0] |= CARDBIT(crd);
 				    redraw = 1;
 				}
 			    }
 			    else
 			    {
-				if (hand[thisplayer].deck[cardx] & 64) 
+				if (lift[0] & CARDBIT(crd)) 
 				{
 				    redraw = 1;
-				    hand[thisplayer].deck[cardx] &= 191;
+				    lift[0] &= ~CARDBIT(crd);
 				}
 				else 
-				if (hand[thisplayer].deck[cardx] & 128) 
+				if (lift[1] & CARDBIT(crd)) 
 				{
 				    redraw = 1;
-				    hand[thisplayer].deck[cardx] |= 64;
-				    hand[thisplayer].deck[cardx] &= 127;
+				    lift[0] |= CARDBIT(crd);
+				    lift[1] &= ~CARDBIT(crd);
 				}
 			    }
 			}
@@ -2989,7 +1650,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 		    case 68: 
         	        if (cardx > 0) cardx--; break;
 		    case 67:
-            		if (cardx < hand[thisplayer].held - 1) cardx++; break;
+			if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 		    default:
 			beep(); continue;
 		}
@@ -3003,8 +1664,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    win = newwin(7,25,0,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) 
-                drawcard(0,i*3,hand[MAXPLAYERS + 1].deck[i]);
+	    drawhand(0, MAXPLAYERS + 1);
 	    if (redraw == 3) 
 	    {
 		refresh();
@@ -3016,17 +1676,15 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	}
 	if (redraw)
 	{
-	    sortcard(thisplayer);
 	    win = newwin(10,80,12,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[thisplayer].held; i++) 
-                drawcard(15,i*3,hand[thisplayer].deck[i]);
+	    drawhand(15, thisplayer);
 	    redraw--;
 	    refresh();
 	}
 
-	if ((i = onewon()))
+	if ((i = onewon(&game)))
 	{
 	    wonarray[i-1] = woncount++;
 	    sprintf(mes, 
@@ -3034,7 +1692,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    messageline(mes);
 	    firstdrop = 1;
 	    getch();
-	    if (!onehaslost() && controlmode)
+	    if (!onehaslost(&game) && game.controlmode)
 	    {
 		firstdrop = 0; cntrlflag = 1;
 	    } 
@@ -3042,7 +1700,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	}
 
     }
-    while ((key != 0) && (!onehaslost()));
+    while ((key != 0) && (!onehaslost(&game)));
 
 #ifndef SHOWCARDS
     wmove(stdscr, 8, 0);
@@ -3050,15 +1708,15 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
     printw("  PgUp/PgDn - push a card up/down\n");
     printw("  left/right arrow - move cursor\n");
     printw("  Enter/Spacebar - do chosen action\n");
-    for (j = 0; j < numplayers; j++)
+    for (j = 0; j < game.numplayers; j++)
     {
         wmove(stdscr, j + 8, 38);
-	if (hand[j].held != 60) 
+	if (game.hand[j].held != 60) 
 	{
 	    if (j == thisplayer) 
-	    printw("You have lost holding %d card(s)", hand[j].held);
+	    printw("You have lost holding %d card(s)", game.hand[j].held);
 	    else
-	    printw("%s has lost with %d card(s)", messagerec[j].name, hand[j].held);
+	    printw("%s has lost with %d card(s)", messagerec[j].name, game.hand[j].held);
 	}
 	else
 	{
@@ -3080,11 +1738,13 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 
 static void playgameserv()
 {
-    int i, j, k, l, key, choice = 0, cardx = 0, betterthis = 0, lastthrow = 100;
+    int i, j, k, l, key, choice = 0, cardx = 0, lastthrow = 100;
     int redraw = 1, turn, firstdrop = 2, cntrlflag = 0, woncount = 1, received;
     WINDOW *win;
     char mes[80];
-    int wonarray[4];
+    int wonarray[4], crd;
+    cardmask pick;
+    comboval betterthis = 0;
 #ifndef SHOWCARDS
     char *orders[] = {"first", "second", "third", "fourth"};
 #endif
@@ -3092,14 +1752,15 @@ static void playgameserv()
     int loopcnt = 0;
     int highestfd, numbytes;
     struct timeval tv;
-    struct fd_set readfds;
+    fd_set readfds;
 
-    hand[MAXPLAYERS].held = 0;
-    hand[MAXPLAYERS + 1].held = 0;
-    hand[MAXPLAYERS + 2].held = 0;
-    hand[MAXPLAYERS + 3].held = 0;
+    for (i = MAXPLAYERS; i < MAXPLAYERS + 2; i++) emptyhand(&game, i);
 
-    shuffle();
+    shuffle(&game);
+    inittracker(&tracker);
+#ifdef DEBUGGING
+    for (i = 0; i < 4; i++) handdebug[i] = game.hand[i];
+#endif
 
 #ifdef DEBUGGING
     fputs("Start of a new game\n", fdbg);
@@ -3107,12 +1768,12 @@ static void playgameserv()
 
     messageline("Found all clients at last... now proceeding");
     messageline("We shall now start the game"); sleep(2);
-    turn = whosfirst();
+    turn = whosfirst(&game);
 
     messagerec[0].networkgame = networkgame;
-    messagerec[0].numplayers = numplayers;
-    messagerec[0].discard = discard;
-    messagerec[0].controlmode = controlmode;
+    messagerec[0].numplayers = game.numplayers;
+    messagerec[0].discard = game.discard;
+    messagerec[0].controlmode = game.controlmode;
     messagerec[0].dispvar = dispvar;
     messagerec[0].pid = getpid();
     strcpy(messagerec[0].name, name);
@@ -3120,7 +1781,7 @@ static void playgameserv()
     close(socketnum);
 
     messagerec[0].thisplayer = 0;
-    messagerec[0].hand = hand[0];
+    messagerec[0].hand = game.hand[0];
     messagebuf = messagerec[0];
     for (l = 0; l < (networkgame - 1); l++)
        while (send(new_fd[l], (void *)&messagebuf, 
@@ -3130,12 +1791,12 @@ static void playgameserv()
 
     for (i = 1; i < networkgame; i++)
     {
-	messagerec[i].numplayers = numplayers;
-    	messagerec[i].discard = discard;
-    	messagerec[i].controlmode = controlmode;
+	messagerec[i].numplayers = game.numplayers;
+	messagerec[i].discard = game.discard;
+	messagerec[i].controlmode = game.controlmode;
     	messagerec[i].dispvar = dispvar;
         messagerec[i].thisplayer = i;
-	messagerec[i].hand = hand[i];
+	messagerec[i].hand = game.hand[i];
         messagebuf = messagerec[i];
 	for (l = 0; l < (networkgame - 1); l++)
            while (send(new_fd[l], (void *)&messagebuf, 
@@ -3144,17 +1805,17 @@ static void playgameserv()
 	messageline(mes);
 	sleep(2);
     }
-    for (i = 0; i < (numplayers - networkgame); i++)
+    for (i = 0; i < (game.numplayers - networkgame); i++)
     {
-	messagerec[networkgame + i].numplayers = numplayers;
-    	messagerec[networkgame + i].discard = discard;
-    	messagerec[networkgame + i].controlmode = controlmode;
+	messagerec[networkgame + i].numplayers = game.numplayers;
+	messagerec[networkgame + i].discard = game.discard;
+	messagerec[networkgame + i].controlmode = game.controlmode;
     	messagerec[networkgame + i].dispvar = dispvar;
 	sprintf(mes, "Computer player %d", i+1);
 	strcpy(messagerec[networkgame + i].name, mes);
         messagerec[networkgame + i].pid = getpid();
 	messagerec[networkgame + i].thisplayer = networkgame + i;
-	messagerec[networkgame + i].hand = hand[i + networkgame];
+	messagerec[networkgame + i].hand = game.hand[i + networkgame];
         messagebuf = messagerec[networkgame + i];
 
 	for (l = 0; l < (networkgame - 1); l++)
@@ -3164,13 +1825,13 @@ static void playgameserv()
 	messageline(mes);
 	sleep(2);
     }
-/*  sprintf(mes, "There are %d computer players", numplayers - networkgame);
+/*  sprintf(mes, "There are %d computer players", game.numplayers - networkgame);
     messageline(mes); sleep(2);*/
 
     leaveok(stdscr, FALSE);
     clear();
-    for (i = 0; i < hand[thisplayer].held; i++) 
-        drawcard(15,i*3,hand[thisplayer].deck[i]);
+    lift[0] = lift[1] = 0;
+    drawhand(15, thisplayer);
     do
     {
 	key = 1;
@@ -3182,18 +1843,15 @@ static void playgameserv()
 	wmove(stdscr, 3, 40); printw("lastthrow %d", lastthrow);
 	
 	wmove(stdscr, 9, 0);
-	for (j = 0; j < numplayers; j++) if (hand[j].held != 60)
+	for (j = 0; j < game.numplayers; j++) if (game.hand[j].held != 60)
 	{
 	    printw("%d:",j);
-            for (i = 0; i < hand[j].held; i++) printw("%c%c ",
-	        ranks[hand[j].deck[i]/4], suits[hand[j].deck[i]%4]); 
+	    printcards(game.hand[j].cards);
             printw("       \n");
         } else printw("         \n");
 
 	wmove(stdscr, 8, 0);printw("lastthrown: ");
-            for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) printw("%c%c ",
-	        ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-		suits[hand[MAXPLAYERS + 1].deck[i]%4]); 
+	    printcards(game.hand[MAXPLAYERS + 1].cards);
 	refresh();
 #else
 
@@ -3202,16 +1860,16 @@ static void playgameserv()
         printw("  PgUp/PgDn - push a card up/down\n");
 	printw("  left/right arrow - move cursor\n");
         printw("  Enter/Spacebar - do chosen action\n");
-	for (j = 0; j < numplayers; j++)
+	for (j = 0; j < game.numplayers; j++)
 	{
 	    wmove(stdscr, j + 8, 38);
-	    if (hand[j].held != 60)
+	    if (game.hand[j].held != 60)
 	    {
 		if (dispvar) {
 		    if (j == thisplayer) 
-		    printw("You have %d card(s)", hand[j].held);
+		    printw("You have %d card(s)", game.hand[j].held);
 		    else
-		    printw("%s has %d card(s)", messagerec[j].name, hand[j].held);
+		    printw("%s has %d card(s)", messagerec[j].name, game.hand[j].held);
 		}
 	    }
 	    else
@@ -3321,8 +1979,8 @@ static void playgameserv()
 	    i = 0;
 	    sprintf(mes, "It is now %s's turn", messagerec[turn].name);
 	    messageline(mes);
-	    sleep(1);
-	    if ((j = makechoice(turn, firstdrop, betterthis)) == 0)
+	    if ((j = computerchoice(turn, firstdrop, betterthis, lastthrow,
+		cntrlflag, &pick)) == 0)
 	    {
 #ifdef DEBUGGING
 	    	fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
@@ -3332,14 +1990,14 @@ static void playgameserv()
 	    	fprintf(fdbg, "redraw %d\n", redraw);
 	    	fprintf(fdbg, "Computer player %d passed.", turn);
 #endif
+		trackpass(&tracker, turn, firstdrop ? 0 : betterthis);
 		messagebuf = messagerec[turn];
 		strcpy(messagebuf.name, messagerec[turn].name);
 		messagebuf.turn = turn;
 		messagebuf.firstdrop = firstdrop;
 		messagebuf.betterthis = betterthis;
-		messagebuf.hand = hand[turn];
-		for (l = 0; l < hand[turn].held; l++)
-		    messagebuf.hand.deck[l] &= 63;
+		messagebuf.hand = game.hand[turn];
+		messagebuf.combo = 0;
 		for (l = 0; l < networkgame - 1; l++)
 		    if (new_fd[l])
 		    while (send(new_fd[l], (void *)&messagebuf, 
@@ -3356,9 +2014,10 @@ static void playgameserv()
 	    else
 	    {
 		messagebuf = messagerec[turn];
-		messagebuf.hand = hand[turn];
-		dropcombo(turn);
-		betterthis = reportcombo(j, mes, messagerec[turn].name);
+		messagebuf.hand = game.hand[turn];
+		messagebuf.combo = pick;
+		dropcombo(&game, turn, pick);
+		betterthis = reportcombo(&game, mes, messagerec[turn].name);
 
 		messagebuf.turn = turn;
 		messagebuf.firstdrop = firstdrop;
@@ -3376,11 +2035,8 @@ static void playgameserv()
 	    	fprintf(fdbg, "betterthis %d\n", betterthis);
 	    	fprintf(fdbg, "redraw %d\n", redraw);
 	    	fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
-	    	fprintf(fdbg, "number of thrown cards %d\n", hand[MAXPLAYERS + 1].held);
-	    	for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	            fprintf(fdbg, "%d %c%c\n", hand[MAXPLAYERS + 1].deck[i],
-	            ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	            suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+		fprintf(fdbg, "number of thrown cards %d\n", game.hand[MAXPLAYERS + 1].held);
+		logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 	    	if (cntrlflag)
 	    	{
@@ -3390,7 +2046,7 @@ static void playgameserv()
 		lastthrow = turn; firstdrop = 0; messageline(mes);
 		redraw = 3;
 	    }
-    	    while (hand[turn = (turn + 1) % numplayers].held == 60);
+	    while (game.hand[turn = (turn + 1) % game.numplayers].held == 60);
 	} else { /* major else */
 
 	for (j = 0; j < (networkgame - 1); j++) 
@@ -3402,7 +2058,25 @@ static void playgameserv()
 	    }
 	    else if (numbytes == sizeof(messagebuf)) 
 	    {
-		if (messagebuf.thisplayer == turn)
+		/* a throw is checked against the hand dealt, not the one
+		sent, and one the rules do not allow is not passed on */
+		if ((messagebuf.thisplayer == turn) &&
+		    (messagebuf.betterthis != betterthis) &&
+		    !validate(&game, turn, firstdrop, betterthis,
+		    messagebuf.combo))
+		{
+#ifdef DEBUGGING
+		    fprintf(fdbg, "illegal throw by player %d refused\n", turn);
+		    logcards(messagebuf.combo);
+#endif
+		    sprintf(mes, "illegal throw by %s refused", 
+			messagebuf.name);
+		    messageline(mes);
+		    sprintf(mes, "Server:  your throw was refused as illegal.");
+		    while (send(new_fd[j], (void *)mes, sizeof(mes), 0) == -1)
+			prerror("send");
+		}
+		else if (messagebuf.thisplayer == turn)
 		{
 		    for (l = 0; l < networkgame - 1; l++)
 			if ((l != j) && (new_fd[l]))
@@ -3410,7 +2084,6 @@ static void playgameserv()
 	    		   sizeof(messagebuf), 0) == -1)
 			   prerror("send");
 
-		    hand[turn] = messagebuf.hand;
 		    if (messagebuf.betterthis == betterthis)
 		    {
 #ifdef DEBUGGING
@@ -3421,6 +2094,7 @@ static void playgameserv()
     	            	fprintf(fdbg, "redraw %d\n", redraw);
     	            	fprintf(fdbg, "Computer player %d passed.", turn);
 #endif
+			trackpass(&tracker, turn, firstdrop ? 0 : betterthis);
 		        if (cntrlflag)
     			{
 	    		    lastthrow = turn; cntrlflag--;
@@ -3431,10 +2105,7 @@ static void playgameserv()
     		    }
     		    else
 		    {
-			dropcombo(turn);
-			betterthis = 
-			reportcombo(messagebuf.betterthis, mes,
-			    messagebuf.name);
+			betterthis = reportcombo(&game, mes, messagebuf.name);
 #ifdef DEBUGGING
 			fprintf(fdbg, "\nfirstdrop %d\n", firstdrop);
     			fprintf(fdbg, "lastthrow %d\n", lastthrow);
@@ -3443,12 +2114,8 @@ static void playgameserv()
     			fprintf(fdbg, "redraw %d\n", redraw);
     			fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
     			fprintf(fdbg, 
-		"number of thrown cards %d\n", hand[MAXPLAYERS + 1].held);
-    			for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-            		fprintf(fdbg, "%d %c%c\n", 
-			    hand[MAXPLAYERS + 1].deck[i],
-            		ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-            		suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+		"number of thrown cards %d\n", game.hand[MAXPLAYERS + 1].held);
+			logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
     			if (cntrlflag)
     			{
@@ -3459,8 +2126,8 @@ static void playgameserv()
 			messageline(mes);
 			redraw = 3;
     		    }
-    		    while (hand[turn = (turn + 1) % 
-			numplayers].held == 60);
+		    while (game.hand[turn = (turn + 1) % 
+			game.numplayers].held == 60);
 		    received = 1;
 		}
 		else
@@ -3472,7 +2139,7 @@ static void playgameserv()
 	    }
 	    else if (!numbytes)
 	    {
-		if (hand[j + 1].held == 60)
+		if (game.hand[j + 1].held == 60)
 		{
 		    close(new_fd[j]); new_fd[j] = 0;
 		    sprintf(mes,
@@ -3563,50 +2230,31 @@ static void playgameserv()
 	    case 13:
 		if (choice == 4)
 		{
-		    for (k = 0; k < hand[thisplayer].held; k++)
-			hand[thisplayer].deck[k] &= 63;
-		    sortcard(thisplayer); redraw = 1; break;
+		    lift[0] = lift[1] = 0;
+		    redraw = 1; break;
 		}
 		else if (choice == 5)
 		{
-		    for (k = 0; k < hand[thisplayer].held; k++)
-		    {
-			switch ((hand[thisplayer].deck[k] & 63) % 4)
-			{
-			    case 0:
-				setbit1(&hand[thisplayer].deck[k], 6, 0);
-				setbit1(&hand[thisplayer].deck[k], 7, 0); break;
-			    case 1:
-				setbit1(&hand[thisplayer].deck[k], 6, 1);
-				setbit1(&hand[thisplayer].deck[k], 7, 0); break;
-			    case 2:
-				setbit1(&hand[thisplayer].deck[k], 6, 0);
-				setbit1(&hand[thisplayer].deck[k], 7, 1); break;
-			    case 3:
-				setbit1(&hand[thisplayer].deck[k], 6, 1);
-				setbit1(&hand[thisplayer].deck[k], 7, 1); break;
-			}
-		    }
-		    sortcard(thisplayer); redraw = 1; break;
+		    lift[0] = game.hand[thisplayer].cards & 
+			(SUITCARDS(1) | SUITCARDS(3));
+		    lift[1] = game.hand[thisplayer].cards & 
+			(SUITCARDS(2) | SUITCARDS(3));
+		    redraw = 1; break;
 		} else if (choice == 1)
 		{
 		    if (turn == thisplayer)
 		    {
-			if (firstdrop || (hand[MAXPLAYERS + 1].held == 1)) 
+			if (firstdrop || (game.hand[MAXPLAYERS + 1].held == 1)) 
 			{
-			    if ((((hand[turn].deck[cardx] & 63) + 1) 
-				> betterthis) || firstdrop)
+			    crd = cardat(thisplayer, cardx);
+			    messagebuf = messagerec[thisplayer];
+			    messagebuf.hand = game.hand[turn];
+			    if ((j = validate(&game, thisplayer, firstdrop, 
+				betterthis, CARDBIT(crd))))
 			    {
-				betterthis = (hand[turn].deck[cardx] & 63)
-				    + 1;
-			        hand[MAXPLAYERS + 1].held = 0;
-
-				messagebuf = messagerec[thisplayer];
-				messagebuf.hand = hand[turn];
-			        for (l = 0; l < hand[turn].held; l++)
-				    messagebuf.hand.deck[l] &= 63;
-				messagebuf.hand.deck[cardx] |= 128;
-		    	    	dropcard(&cardx, thisplayer);
+				betterthis = j;
+				messagebuf.combo = CARDBIT(crd);
+				if ((cardx >= game.hand[thisplayer].held) && cardx) cardx--;
 
 			        messagebuf.turn = turn;
 			        messagebuf.firstdrop = firstdrop;
@@ -3624,12 +2272,8 @@ static void playgameserv()
 	    			fprintf(fdbg, "redraw %d\n", redraw);
 	    			fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    			fprintf(fdbg, "number of thrown cards %d\n",
-				    hand[MAXPLAYERS + 1].held);
-	    			for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	        		    fprintf(fdbg, "%d %c%c\n", 
-				    hand[MAXPLAYERS + 1].deck[i],
-	        		    ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	        		    suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+				    game.hand[MAXPLAYERS + 1].held);
+				logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 			    	if (cntrlflag)
 			    	{
@@ -3639,9 +2283,11 @@ static void playgameserv()
 		    	    	messageline("you have dropped a single card");
 	             		lastthrow = turn;
 			    	firstdrop = 0;
-		   		while (hand[turn = (turn + 1) % 
-				    numplayers].held == 60);
+				while (game.hand[turn = (turn + 1) % 
+				    game.numplayers].held == 60);
 			    }
+			    else if (firstdrop == 2) 
+				messageline("the first throw must hold the 3D");
 			    else messageline("your card is too low");
 			}
 			else messageline("you may not drop a single card!!!");
@@ -3685,14 +2331,14 @@ static void playgameserv()
 	    		    fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    		    fprintf(fdbg, "user has passed.");
 #endif
+			    trackpass(&tracker, turn, firstdrop ? 0 : betterthis);
 
 			    messagebuf = messagerec[thisplayer];
 			    messagebuf.turn = turn;
 			    messagebuf.firstdrop = firstdrop;
 			    messagebuf.betterthis = betterthis;
-			    messagebuf.hand = hand[turn];
-			    for (l = 0; l < hand[turn].held; l++)
-			        messagebuf.hand.deck[l] &= 63;
+			    messagebuf.hand = game.hand[turn];
+			    messagebuf.combo = 0;
 			    for (l = 0; l < networkgame - 1; l++)
 			        while (send(new_fd[l], (void *)&messagebuf, 
 		    	    	    sizeof(messagebuf), 0) == -1)
@@ -3703,8 +2349,8 @@ static void playgameserv()
 				lastthrow = turn;
 				cntrlflag--;
 			    }
-	   		    while (hand[turn = (turn + 1) % 
-			       numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+			       game.numplayers].held == 60);
 			    if (firstdrop == 2) firstdrop--;
 		        }
 		    }
@@ -3732,35 +2378,16 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 		    if (turn == thisplayer)
 		    { 
 			k = cardx;
-			hand[MAXPLAYERS + 2].held = 0;
-			hand[MAXPLAYERS + 3] = hand[thisplayer];
-		    	i = hand[thisplayer].deck[cardx] >> 6;
-		    	j = 0;
 
 			messagebuf = messagerec[thisplayer];
 			messagebuf.turn = turn;
 			messagebuf.firstdrop = firstdrop;
-			messagebuf.hand = hand[turn];
-			for (l = 0; l < hand[turn].held; l++)
-			    messagebuf.hand.deck[l] &= 63;
-
-			l = j;
-		    	while ((j < hand[thisplayer].held) && 
-			    (hand[thisplayer].held))
-		        {
-			    if (i == (hand[thisplayer].deck[j] >> 6))
-			    {
-				messagebuf.hand.deck[l] |= 128;
-		            	dropcard2(&j, thisplayer);
-			    	cardx = j;
-			    }
-			    else j++;
-			    l++;
-		    	} /* this transfers selected cards to 
-			hand[MAXPLAYERS + 2] */
-			if ((j = validate(firstdrop, betterthis)))
+			messagebuf.hand = game.hand[turn];
+			messagebuf.combo = pickcombo(&cardx);
+			if ((j = validate(&game, thisplayer, firstdrop, betterthis,
+			    messagebuf.combo)))
 			{
-			    betterthis = reportcombo(j, mes, name);
+			    betterthis = reportcombo(&game, mes, name);
 
 			    messagebuf.betterthis = betterthis;
 			    for (l = 0; l < networkgame - 1; l++)
@@ -3776,12 +2403,8 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 			    fprintf(fdbg, "redraw %d\n", redraw);
 			    fprintf(fdbg, "cntrlflag %d\n", cntrlflag);
 	    		    fprintf(fdbg, "number of thrown cards %d\n",
-				hand[MAXPLAYERS + 1].held);
-	    		    for (i = 0; i < hand[MAXPLAYERS + 1].held; i++)
-	        	    fprintf(fdbg, "%d %c%c\n",
-				hand[MAXPLAYERS + 1].deck[i],
-	        		ranks[hand[MAXPLAYERS + 1].deck[i]/4], 
-	        		suits[hand[MAXPLAYERS + 1].deck[i]%4]);
+				game.hand[MAXPLAYERS + 1].held);
+			    logcards(game.hand[MAXPLAYERS + 1].cards);
 #endif
 			    if (cntrlflag)
 			    {
@@ -3791,8 +2414,8 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 			    messageline(mes);
              		    lastthrow = turn;
 			    firstdrop = 0;
-			    while (hand[turn = (turn + 1) % 
-				numplayers].held == 60);
+			    while (game.hand[turn = (turn + 1) % 
+				game.numplayers].held == 60);
 		        }
 			else 
 			{
@@ -3824,7 +2447,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    case '4': 
                 if (cardx > 0) cardx--; break;
 	    case '6':
-                if (cardx < hand[thisplayer].held - 1) cardx++; break;
+		if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 	    case 27:
 	        if ((key = getch()) != 91)
 		{
@@ -3836,36 +2459,37 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
                     case 54:
                         if (getch() == 126)
 			{
+			    crd = cardat(thisplayer, cardx);
 			    if (key == 53)
 			    {
-				if (hand[thisplayer].deck[cardx] & 64) 
+				if (lift[0] & CARDBIT(crd)) 
 				{
-				    if (!(hand[thisplayer].deck[cardx] & 128))
+				    if (!(lift[1] & CARDBIT(crd)))
  				    {
-					hand[thisplayer].deck[cardx] |= 128;
-					hand[thisplayer].deck[cardx] &= 191;
+					lift[1] |= CARDBIT(crd);
+					lift[0] &= ~CARDBIT(crd);
 					redraw = 1;
 				    }
 				}
 				else 
 				{
-				    hand[thisplayer].deck[cardx] |= 64;
+				    lift[0] |= CARDBIT(crd);
 				    redraw = 1;
 				}
 			    }
 			    else
 			    {
-				if (hand[thisplayer].deck[cardx] & 64) 
+				if (lift[0] & CARDBIT(crd)) 
 				{
 				    redraw = 1;
-				    hand[thisplayer].deck[cardx] &= 191;
+				    lift[0] &= ~CARDBIT(crd);
 				}
 				else 
-				if (hand[thisplayer].deck[cardx] & 128) 
+				if (lift[1] & CARDBIT(crd)) 
 				{
 				    redraw = 1;
-				    hand[thisplayer].deck[cardx] |= 64;
-				    hand[thisplayer].deck[cardx] &= 127;
+				    lift[0] |= CARDBIT(crd);
+				    lift[1] &= ~CARDBIT(crd);
 				}
 			    }
 			}
@@ -3878,7 +2502,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 		    case 68: 
         	        if (cardx > 0) cardx--; break;
 		    case 67:
-            		if (cardx < hand[thisplayer].held - 1) cardx++; break;
+			if (cardx < game.hand[thisplayer].held - 1) cardx++; break;
 		    default:
 			beep(); continue;
 		}
@@ -3893,8 +2517,7 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    win = newwin(7,25,0,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[MAXPLAYERS + 1].held; i++) 
-                drawcard(0,i*3,hand[MAXPLAYERS + 1].deck[i]);
+	    drawhand(0, MAXPLAYERS + 1);
 	    if (redraw == 3) 
 	    {
 		refresh();
@@ -3905,16 +2528,14 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	}
 	if (redraw)
 	{
-	    sortcard(thisplayer);
 	    win = newwin(10,80,12,0);
 	    overwrite(win, stdscr);
             delwin(win);
-	    for (i = 0; i < hand[thisplayer].held; i++) 
-                drawcard(15,i*3,hand[thisplayer].deck[i]);
+	    drawhand(15, thisplayer);
 	    redraw--;
 	}
 
-	if ((i = onewon()))
+	if ((i = onewon(&game)))
 	{
 	    wonarray[i - 1] = woncount++;
 	    sprintf(mes,
@@ -3922,13 +2543,13 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
 	    messageline(mes);
 	    firstdrop = 1;
 	    getch();
-	    if (!onehaslost() && controlmode)
+	    if (!onehaslost(&game) && game.controlmode)
 	    {
 		firstdrop = 0; cntrlflag = 1;
 	    } else betterthis = 0;
 	}
 
-    } while ((key != 0) && (!onehaslost()));
+    } while ((key != 0) && (!onehaslost(&game)));
 
 #ifndef SHOWCARDS
     wmove(stdscr, 8, 0);
@@ -3936,15 +2557,15 @@ messageline("I'd appreciate it if you'd pass when its your turn.");
     printw("  PgUp/PgDn - push a card up/down\n");
     printw("  left/right arrow - move cursor\n");
     printw("  Enter/Spacebar - do chosen action\n");
-    for (j = 0; j < numplayers; j++)
+    for (j = 0; j < game.numplayers; j++)
     {
         wmove(stdscr, j + 8, 38);
-	if (hand[j].held != 60) 
+	if (game.hand[j].held != 60) 
 	{
 	    if (j == thisplayer) 
-	    printw("You have lost holding %d card(s)", hand[j].held);
+	    printw("You have lost holding %d card(s)", game.hand[j].held);
 	    else
-	    printw("%s has lost with %d card(s)", messagerec[j].name, hand[j].held);
+	    printw("%s has lost with %d card(s)", messagerec[j].name, game.hand[j].held);
 	}
 	else
 	{
@@ -3968,7 +2589,7 @@ static int checkifagree(int who)
     char mes[80];
     int conflict = 0;
 
-    if (messagerec[who].numplayers != numplayers)
+    if (messagerec[who].numplayers != game.numplayers)
     {
 	if (networkgame == 1)
 	    sprintf(mes, "The server wants %d players.", 
@@ -3979,7 +2600,7 @@ static int checkifagree(int who)
 	messageline(mes); sleep(1); conflict = 1;
     }
 
-    if (messagerec[who].discard != discard)
+    if (messagerec[who].discard != game.discard)
     {
 	if (networkgame == 1)
 	    sprintf(mes, "The server wants to discard %d card(s).", 
@@ -3990,7 +2611,7 @@ static int checkifagree(int who)
 	messageline(mes); sleep(1); conflict = 1;
     }
 
-    if (messagerec[who].controlmode != controlmode)
+    if (messagerec[who].controlmode != game.controlmode)
     {
 	if (networkgame == 1)
 	{
@@ -4049,7 +2670,7 @@ static void initgame()
     int key, highestfd, numbytes;
     char mes[80];
     struct timeval tv;
-    struct fd_set readfds;
+    fd_set readfds;
 
     messageline("");
     clear();
@@ -4059,12 +2680,12 @@ static void initgame()
 "**************************** Pusoy Dos Main Menu ***************************");
     	mvcaddstr(2 + 2*choice, 
 	"===>                                                            <===");
-    	sprintf(mes, "Change number of players:  %d", numplayers);
+	sprintf(mes, "Change number of players:  %d", game.numplayers);
     	mvcaddstr(2, mes);
-    	sprintf(mes, "Change number of cards to discard:  %d", discard);
+	sprintf(mes, "Change number of cards to discard:  %d", game.discard);
     	mvcaddstr(4, mes);
 
-	if (!controlmode) mvcaddstr(6,
+	if (!game.controlmode) mvcaddstr(6,
 	    "         how control transfers:  immediate          ");
  	else mvcaddstr(6, 
 	    "how control transfers:  give others a beating chance");
@@ -4104,33 +2725,33 @@ static void initgame()
 	    case 13:
 		if (choice == 0)
 		{
-		    numplayers = numplayers % 4 + 1;
-		    if (numplayers == 1) numplayers++;
-		    switch (numplayers)
+		    game.numplayers = game.numplayers % 4 + 1;
+		    if (game.numplayers == 1) game.numplayers++;
+		    switch (game.numplayers)
 		    {
 			case 2:
 			case 4:
-			    discard = 0; break;
+			    game.discard = 0; break;
 			case 3:
-			    discard = 1; break;
+			    game.discard = 1; break;
 			default:
 			    fatal("illegal number of players set");
 		    }
-		    if (networkgame > numplayers) networkgame = numplayers;
+		    if (networkgame > game.numplayers) networkgame = game.numplayers;
 		} 
 		else if (choice == 1)
 		{
-		    if (key == 13) discard = (discard + 1) % 27;
+		    if (key == 13) game.discard = (game.discard + 1) % 27;
 		    else 
 		    {
-			if (discard == 0) discard = 26;
-			else --discard;
+			if (game.discard == 0) game.discard = 26;
+			else --game.discard;
 		    }
 		    key = 0;
 		} 
 		else if (choice == 2)
 		{
-		    controlmode = (controlmode + 1) % 2;
+		    game.controlmode = (game.controlmode + 1) % 2;
 		    key = 0;
 		} 
 		else if (choice == 3)
@@ -4145,7 +2766,7 @@ static void initgame()
 		}
 		else if (choice == 5)
 		{
-		    networkgame = (networkgame + 1) % (numplayers + 1);
+		    networkgame = (networkgame + 1) % (game.numplayers + 1);
 		    key = 0;
 		}
 		else if (choice == 6)
@@ -4323,10 +2944,10 @@ static void initgame()
 			    messageline(mes);
 
 			    messagebuf.pid = getpid();
-			    messagebuf.numplayers = numplayers;
-			    messagebuf.discard = discard;
+			    messagebuf.numplayers = game.numplayers;
+			    messagebuf.discard = game.discard;
 			    messagebuf.thisplayer = thisplayer;
-			    messagebuf.controlmode = controlmode;
+			    messagebuf.controlmode = game.controlmode;
 			    messagebuf.dispvar = dispvar;
 			    strcpy(messagebuf.name, name);
 			    while (send(new_fd[j], (void *)&messagebuf, 
@@ -4421,9 +3042,9 @@ static void initgame()
             	    close(socketnum); key = 0;
         	}
 
-		messagebuf.numplayers = numplayers;
-		messagebuf.discard = discard;
-		messagebuf.controlmode = controlmode;
+		messagebuf.numplayers = game.numplayers;
+		messagebuf.discard = game.discard;
+		messagebuf.controlmode = game.controlmode;
 		messagebuf.dispvar = dispvar;
 		messagebuf.pid = getpid();
 		strcpy(messagebuf.name, name);
@@ -4544,6 +3165,7 @@ static void intro()
     int i;
 
     srand(time(0L) + getpid());	/* Kick the random number generator */
+    game.seed = rand();
 
     (void) signal(SIGINT,uninitgame);
     (void) signal(SIGINT,uninitgame);
@@ -4592,26 +3214,35 @@ static void do_options(int c, char *op[])
             {
                 default:
 	        case '?':
-	  	    (void) fprintf(stderr, "Usage is simply:  %s\n", op[0]);
+		    (void) fprintf(stderr, "Usage is:  %s [-t ms]\n", op[0]);
+		    (void) fprintf(stderr, 
+			"  -t ms  how long each computer turn takes (%d)\n",
+			THINKTIME);
 	  	    exit(1);
   	  	    break;
-/*      	case '-':
+		case '-':
 	  	    switch(op[i][1])
 	  	    {
-	    		case 'b': break;
-	    		case 's': break;
-	    		case 'c': break;
+			case 't': 
+			    if ((i + 1 < c) && (atoi(op[i + 1]) > 0))
+			    {
+				thinktime = atoi(op[++i]);
+				break;
+			    }
+			    /* fall through */
 	    		default:
               		    (void) fprintf(stderr,
 				"Bad arg: type \"%s ?\" for usage message\n", op[0]);
 	      		    exit(1);
-          	    } */
+		    }
+		    break;
       	    }
         }
     }
 }
 
 int main(int argc, char *argv[]) {
+    int i, trees;
 
     if (gethostname(hostname, sizeof(hostname)) == -1)
     {
@@ -4619,6 +3250,18 @@ int main(int argc, char *argv[]) {
 	strcpy(hostname, "balut.admu.edu.ph");
     }
     do_options(argc, argv);
+    enginefatal = fatal;
+    initcombo5();
+    initplanner(&planner);
+    game.planner = &planner;
+    game.tracker = &tracker;
+    trees = sysconf(_SC_NPROCESSORS_ONLN);
+    if ((trees < 1) || (trees > SEARCHTREES)) trees = SEARCHTREES;
+    for (i = 0; i < MAXPLAYERS; i++) 
+	initsearcher(&searcher[i], trees, TREENODES);
+    if (!initsolver(&solver, SOLVESLOTS, SOLVENODES))
+	fputs("no room to solve endings, the computer will search them.\n",
+	    stderr);
 
 #ifdef DEBUGGING
     if ((fdbg = fopen("pusoy.log", "wt+")) == NULL) 
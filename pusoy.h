@@ -0,0 +1,241 @@
+/*
+pusoy.h
+
+The rules and the AI of PUSOY-DOS, kept apart from the terminal game so
+that other programs can deal, list the legal plays, play them and ask the
+computer for its choice.  None of it needs curses or sockets.
+
+*/
+
+#ifndef PUSOY_H
+#define PUSOY_H
+
+#define NUMCARDS 52
+#define MAXPLAYERS 4
+
+/* a set of cards is kept as a bit mask:  card n (rank n / 4, suit n % 4) is
+bit n, so the suits of one rank sit next to each other and walking a mask
+from its lowest bit up gives the cards in sorted order */
+typedef unsigned long long cardmask;
+#define CARDBIT(c)	((cardmask)1 << (c))
+#define SUITCARDS(s)	(0x1111111111111ULL << (s))	/* all 13 of a suit */
+#define RANKCARDS(r)	((cardmask)15 << ((r) * 4))	/* all 4 of a rank */
+#define ALLCARDS	(CARDBIT(NUMCARDS - 1) * 2 - 1)	/* the whole deck */
+
+/* the strength of a play, packed so that a plain compare orders plays of
+the same number of cards:  the number of cards from bit 24 up, the kind
+of play in bits 16-23 and in the low bits its value on the betterthis
+scale the finders work in (see lookfor5).  0 stands for no play. */
+typedef unsigned int comboval;
+#define COMBOVAL(n, kind, key)	(((comboval)(n) << 24) | ((kind) << 16) | (key))
+#define COMBOCARDS(v)	((int)((v) >> 24))
+#define COMBOKIND(v)	((int)(((v) >> 16) & 255))
+#define COMBOKEY(v)	((int)((v) & 65535))
+
+/* kinds of play, weakest first */
+#define SINGLE		1
+#define PAIR		2
+#define TRIO		3
+#define STRAIGHT	4
+#define FLUSH		5
+#define FULLHOUSE	6
+#define FOURKIND	7
+#define STRAIGHTFLUSH	8
+#define ROYALFLUSH	9
+
+struct DeckStruct
+{
+    cardmask cards;	/* the cards in this hand */
+    int held;		/* number of cards in this hand */
+    unsigned char count[13];	/* number of cards held of each rank */
+    unsigned short suitranks[4];	/* ranks held of each suit, bit per rank */
+    unsigned long long key;	/* Zobrist key of the cards, see gamekey() */
+};
+
+/* a bounded cache of the choices of makechoice(), kept by the hand, the
+last play and firstdrop.  slots go in 4 way buckets, each with a clock 
+hand, and a full bucket gives up the first slot from its hand on that has
+not been used since the hand last went by (CLOCK) */
+struct ChoiceEntry
+{
+    cardmask cards, pick;	/* the hand, and the play chosen for it */
+    comboval betterthis, value;
+    unsigned char firstdrop, lastheld, used;
+    unsigned char hand;		/* the bucket's clock hand, in its first slot */
+};
+
+struct ChoiceCache
+{
+    struct ChoiceEntry *slot;
+    unsigned int buckets;	/* a power of 2 */
+    unsigned long hits, misses;
+};
+
+/* everything the rules and the AI know about one game.  the engine
+functions get it passed in and keep nothing of their own between calls, 
+so a process may run any number of games, on as many threads as it likes
+once initcombo5() has been called, as long as no two threads use the 
+same GameState, or the same cache, planner or tracker, at once */
+struct GameState
+{
+    int numplayers;	/* the number of players in the game */
+    int discard;	/* the number of cards to discard */
+    int controlmode;    /* how control transfers */
+    unsigned int seed;	/* of the deal */
+    struct DeckStruct hand[MAXPLAYERS + 2];  /* 0-3 for players; 4 for */
+			 /* discards; 5 for last play */
+    /* where the game stands, kept by newgame() and playmove() */
+    int turn;		/* the hand to play */
+    int firstdrop;	/* 1 if in control, 2 if it must hold the lowest card */
+    int lastthrow;	/* the hand that made the last play */
+    int cntrlflag;	/* passes left before control goes to lastthrow */
+    comboval betterthis;	/* what the next play has to beat */
+    struct ChoiceCache *cache;	/* for makechoice(), if not NULL */
+    struct Planner *planner;	/* for makechoice(), if not NULL */
+    struct Tracker *tracker;	/* for the searching players, if not NULL */
+};
+
+/* every play there is:  52 singles, 78 pairs, 52 trios and 19716
+5 card plays */
+#define MAXMOVES	19898
+
+struct MoveStruct
+{
+    cardmask cards;
+    comboval value;
+};
+
+/* plans of the hands for makechoice():  the fewest plays each set of a
+hand's cards can go out in, as far as they have been worked out, so that
+it does not break up the plays it needs.  hands of more than PLANCARDS 
+cards go without. */
+#define PLANCARDS	17
+
+struct HandPlan
+{
+    cardmask cards;		/* the hand planned for, 0 for none */
+    signed char bit[NUMCARDS];	/* the bit of each of its cards */
+    int nplays, start[PLANCARDS + 1];	/* its plays, by their lowest card */
+    unsigned int play[MAXMOVES];
+    unsigned char turns[1 << PLANCARDS];	/* 1 + the fewest plays, 0 if
+						   not known yet */
+};
+
+struct Planner
+{
+    struct HandPlan hand[MAXPLAYERS];
+    struct MoveStruct moves[MAXMOVES];	/* the plays of the hand planned */
+};
+
+extern char *kindname[];	/* what to call each kind of play */
+/* called on internal errors; it should not return */
+extern void (*enginefatal)(char *s);
+
+/* sets of cards */
+int popcount(cardmask m);
+int lowcard(cardmask m);
+int maskcards(cardmask m, int *deck);
+
+/* the hands */
+void emptyhand(struct GameState *g, int who);
+void addcard(struct GameState *g, int crd, int who);
+void removecard(struct GameState *g, int crd, int who);
+cardmask unseen(struct GameState *g, int who);
+void shuffle(struct GameState *g);
+int whosfirst(struct GameState *g);
+void dropcard(struct GameState *g, int crd, int who);
+void dropcombo(struct GameState *g, int who, cardmask combo);
+int onewon(struct GameState *g);
+int onehaslost(struct GameState *g);
+
+/* the plays; initcombo5() has to be called once before any of them */
+void initcombo5();
+comboval playvalue(cardmask m);
+void playvalues(cardmask *sets, comboval *out, int n);
+int genmoves(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, struct MoveStruct *moves);
+comboval makechoice(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, cardmask *pick);
+void initcache(struct ChoiceCache *c, struct ChoiceEntry *slot, int n);
+void initplanner(struct Planner *pl);
+comboval validate(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, cardmask combo);
+comboval reportcombo(struct GameState *g, char *mes, char *whos);
+
+/* a whole game */
+void newgame(struct GameState *g);
+int playmove(struct GameState *g, cardmask combo);
+unsigned long long gamekey(struct GameState *g);
+unsigned long long mixkey(unsigned long long z);
+
+/* the searching players, in pusoyai.c;  they choose for the hand whose
+turn it is in g */
+#define MAXTHREADS	64
+
+/* the trees of an ISMCTS player, one a thread, kept from one of its turns
+to the next */
+struct TreeNode;
+struct PonderWork;
+struct SearchTree
+{
+    struct TreeNode *node;	/* the root first */
+    int used;
+    unsigned long long seed;	/* of its deals */
+};
+
+struct Searcher
+{
+    int threads, size;		/* the trees, and the nodes of each */
+    struct SearchTree tree[MAXTHREADS];
+    unsigned long kept;		/* nodes taken up by the last search */
+    struct PonderWork *ponder;	/* while it ponders, see startponder() */
+};
+
+/* a table of the two handed endings solved, and the plays down the line
+being searched */
+struct SolveEntry
+{
+    unsigned long long key;	/* gamekey() of the position */
+    int win;			/* if the hand to play wins it */
+};
+
+struct Solver
+{
+    struct SolveEntry *slot;
+    int size;			/* a power of 2 */
+    struct MoveStruct *moves;
+    int room;
+    unsigned long nodes, maxnodes;	/* searched by the last solve, and
+					   the most it may search */
+    int gaveup;
+    double deadline;		/* of the solve going on, 0 for none */
+    double secs;		/* taken by the last solve */
+};
+
+/* what each hand's passes tell of its cards, for the deals of the 
+searching players */
+struct Tracker
+{
+    comboval nobeat[MAXPLAYERS][6];	/* the lowest play of each number
+					   of cards each passed on */
+};
+
+comboval montecarlo(struct GameState *g, int rollouts, int threads,
+    cardmask *pick);
+void initsearcher(struct Searcher *s, int threads, int size);
+void freesearcher(struct Searcher *s);
+comboval ismcts(struct GameState *g, struct Searcher *s, int iterations,
+    double deadline, cardmask *pick);
+int startponder(struct GameState *g, struct Searcher *s, int who,
+    double deadline);
+void stopponder(struct Searcher *s);
+double wallclock();
+void inittracker(struct Tracker *t);
+void trackpass(struct Tracker *t, int who, comboval betterthis);
+int initsolver(struct Solver *s, int n, unsigned long maxnodes);
+void freesolver(struct Solver *s);
+int solvable(struct GameState *g, int limit);
+int solve(struct GameState *g, struct Solver *s, double deadline,
+    cardmask *pick);
+
+#endif /* PUSOY_H */
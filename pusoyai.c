@@ -0,0 +1,915 @@
+/*
+pusoyai.c
+
+The searching computer players.  Where makechoice() takes the first play
+the finders come to, these try the plays a hand has against deals of the
+cards it cannot see, and keep the one that does best.  The deals are
+shared out over threads.  See pusoy.h.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "pusoy.h"
+
+#define CACHESLOTS	4096	/* of each thread's makechoice() cache */
+
+/* the share of the deals one thread plays out */
+struct MonteWork
+{
+    struct GameState *g;	/* where the game stands */
+    struct MoveStruct *moves;	/* the plays to try; a 0 one is a pass */
+    int nmoves;
+    int first, step, deals;	/* deals first, first + step, ... */
+    long *score;		/* the places of each play, added up */
+};
+
+/* splitmix64, from a state of each deal's own */
+static unsigned long long nextrand(unsigned long long *s)
+{
+    return mixkey(*s += 0x9e3779b97f4a7c15ULL);
+}
+
+/* seconds on the wall clock, for deadlines */
+double wallclock()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* the number of threads to use for threads asked for, 0 being one a 
+processor */
+static int numthreads(int threads)
+{
+    if (threads < 1) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    return (threads > MAXTHREADS) ? MAXTHREADS : threads;
+}
+
+/* runs fn on the n pieces of work of size bytes each at work, each on a
+thread of its own but for the first, which this thread does along with
+any a thread could not be started for.  the threads are started afresh
+for each search:  that takes well under a millisecond, next to searches
+of a second or so, and leaves nothing running between them */
+static void runthreads(void *(*fn)(void *), void *work, int size, int n)
+{
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS], t;
+
+    for (t = 0; t < n; t++) started[t] = t && 
+	!pthread_create(&tid[t], NULL, fn, (char *)work + t * size);
+    for (t = 0; t < n; t++) if (!started[t]) fn((char *)work + t * size);
+    for (t = 0; t < n; t++) if (started[t]) pthread_join(tid[t], NULL);
+}
+
+/* what the passes of the hands tell of their cards.  a hand that passes
+when it has to beat a play is likely not to hold one that does, but the
+searching players and the planner pass on purpose, as people do, so it is
+no more than likely:  deals where a hand holds a play that beats one it
+passed on are dealt again, a few times, and nothing is ruled out for good */
+
+#define DEALTRIES	32	/* deals tried for one that fits the passes */
+
+void inittracker(struct Tracker *t)
+{
+    int i, k;
+
+    for (i = 0; i < MAXPLAYERS; i++)
+	for (k = 0; k < 6; k++) t->nobeat[i][k] = 0;
+}
+
+/* hand who passed when it had to beat betterthis, 0 if it did not have 
+to beat anything */
+void trackpass(struct Tracker *t, int who, comboval betterthis)
+{
+    int k = COMBOCARDS(betterthis);
+
+    if (!betterthis) return;
+    if (!t->nobeat[who][k] || (betterthis < t->nobeat[who][k]))
+	t->nobeat[who][k] = betterthis;
+}
+
+/* 1 if hand who in g holds a play of as many cards as v that beats it.
+moves[] has room for the plays of a hand. */
+static int hasbeater(struct GameState *g, int who, comboval v,
+    struct MoveStruct *moves)
+{
+    cardmask c = g->hand[who].cards;
+    int i, n, r, s;
+
+    switch (COMBOCARDS(v))
+    {
+	case 1:
+	    return (c & ~(CARDBIT(COMBOKEY(v)) - 1)) != 0;
+	case 2:
+	    for (r = 12; r >= 0; r--) if (g->hand[who].count[r] >= 2)
+	    {
+		for (s = 3; !(c & CARDBIT(r * 4 + s)); s--);
+		if (COMBOVAL(2, PAIR, r * 4 + s) > v) return 1;
+	    }
+	    return 0;
+	case 3:
+	    for (r = 12; r >= 0; r--) if ((g->hand[who].count[r] >= 3) &&
+		(COMBOVAL(3, TRIO, r + 1) > v)) return 1;
+	    return 0;
+    }
+    n = genmoves(g, who, 1, v, moves);
+    for (i = 0; i < n; i++) if (COMBOCARDS(moves[i].value) == 5) return 1;
+    return 0;
+}
+
+/* deals the cards hand who cannot see to the players still in, each 
+getting as many as it holds.  cards left over are the ones discarded at 
+the deal. */
+static void dealunseen(struct GameState *g, int who, unsigned long long *s)
+{
+    int deck[NUMCARDS], i, j, k, n, t, crd;
+
+    n = maskcards(unseen(g, who), deck);
+    for (t = 0, i = 0; i < g->numplayers; i++)
+    {
+	if ((i == who) || (g->hand[i].held == 60)) continue;
+	k = g->hand[i].held;
+	emptyhand(g, i);
+	for (; k--; t++)
+	{
+	    j = t + nextrand(s) % (n - t);
+	    crd = deck[j]; deck[j] = deck[t]; deck[t] = crd;
+	    addcard(g, crd, i);
+	}
+    }
+}
+
+/* a deal of the cards hand who cannot see, for the searching players.
+with a tracker, deals are tried for one where no hand holds a play that 
+beats one it passed on, else the last one tried is kept.  moves[] is room
+for the plays of a hand, for the trying. */
+static void determinize(struct GameState *g, int who, unsigned long long *s,
+    struct MoveStruct *moves)
+{
+    struct Tracker *tr = g->tracker;
+    struct GameState d;
+    int j, k, tries, bad = 1;
+
+    if (!tr)
+    {
+	dealunseen(g, who, s);
+	return;
+    }
+    for (tries = 0; bad && (tries < DEALTRIES); tries++)
+    {
+	d = *g;
+	dealunseen(&d, who, s);
+	for (bad = 0, k = 0; !bad && (k < g->numplayers); k++)
+	    if ((k != who) && (d.hand[k].held != 60))
+		for (j = 1; j < 6; j++) if (tr->nobeat[k][j] &&
+		    hasbeater(&d, k, tr->nobeat[k][j], moves)) bad = 1;
+    }
+    for (k = 0; k < g->numplayers; k++) g->hand[k] = d.hand[k];
+}
+
+/* the legal plays of the hand to play in g, and a pass when it may pass,
+into moves[], which must have room for MAXMOVES + 1 */
+static int plays(struct GameState *g, struct MoveStruct *moves)
+{
+    int n = genmoves(g, g->turn, g->firstdrop, g->betterthis, moves);
+
+    if (!g->firstdrop)
+    {
+	moves[n].cards = 0; moves[n++].value = 0;
+    }
+    return n;
+}
+
+/* the number of players other than who that are out */
+static int outbefore(struct GameState *g, int who)
+{
+    int i, k = 0;
+
+    for (i = 0; i < g->numplayers; i++)
+	if ((i != who) && (g->hand[i].held == 60)) k++;
+    return k;
+}
+
+/* plays g out with makechoice() for every hand until who goes out or is
+the last one left.  returns how many went out before who did. */
+static int rollout(struct GameState *g, int who)
+{
+    cardmask pick;
+    int out = outbefore(g, who);
+
+    while ((g->hand[who].held != 60) && !onehaslost(g))
+    {
+	makechoice(g, g->turn, g->firstdrop, g->betterthis, &pick);
+	if (!playmove(g, pick)) enginefatal("rollout made an illegal play");
+    }
+    return outbefore(g, who) - out;
+}
+
+static void *montework(void *arg)
+{
+    struct MonteWork *w = arg;
+    struct GameState deal, next;
+    struct ChoiceCache cache;
+    struct ChoiceEntry *slot;
+    struct MoveStruct *moves;
+    unsigned long long s;
+    int d, i, who = w->g->turn;
+
+    slot = malloc(CACHESLOTS * sizeof(struct ChoiceEntry));
+    if (slot) initcache(&cache, slot, CACHESLOTS);
+    moves = malloc(MAXMOVES * sizeof(struct MoveStruct));
+    for (d = w->first; moves && (d < w->deals); d += w->step)
+    {
+	/* the same deal for every play, so that they are told apart by
+	what they do and not by the luck of the deal */
+	deal = *w->g;
+	deal.cache = slot ? &cache : NULL;
+	deal.planner = NULL;
+	s = gamekey(w->g) ^ ((unsigned long long)d << 32);
+	determinize(&deal, who, &s, moves);
+	for (i = 0; i < w->nmoves; i++)
+	{
+	    next = deal;
+	    if (!playmove(&next, w->moves[i].cards))
+		enginefatal("montecarlo tried an illegal play");
+	    w->score[i] += rollout(&next, who);
+	}
+    }
+    free(moves);
+    free(slot);
+    return NULL;
+}
+
+/* the choice of a determinized Monte Carlo player for the hand whose turn
+it is in g, g's turn state being kept as playmove() keeps it.  each legal
+play, and a pass when one is allowed, is played out on about rollouts /
+the number of plays deals of the unseen cards, on threads threads (one a
+processor if 0), and the one whose hand goes out soonest on average wins.
+puts its cards in *pick and returns its value, or 0 to pass. */
+comboval montecarlo(struct GameState *g, int rollouts, int threads,
+    cardmask *pick)
+{
+    struct MoveStruct *moves;
+    struct MonteWork work[MAXTHREADS];
+    long *score;
+    comboval v;
+    int i, t, n, deals, best;
+
+    *pick = 0;
+    if (!(moves = malloc((MAXMOVES + 1) * sizeof(struct MoveStruct))))
+	return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+    if ((n = plays(g, moves)) < 2)
+    {
+	v = n ? moves[0].value : 0;
+	if (n) *pick = moves[0].cards;
+	free(moves);
+	return v;
+    }
+
+    threads = numthreads(threads);
+    deals = (rollouts + n - 1) / n;
+    if (deals < 1) deals = 1;
+    if (threads > deals) threads = deals;
+    if (!(score = calloc(threads * n, sizeof(long))))
+    {
+	free(moves);
+	return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+    }
+
+    for (t = 0; t < threads; t++)
+    {
+	work[t].g = g;
+	work[t].moves = moves;
+	work[t].nmoves = n;
+	work[t].first = t;
+	work[t].step = threads;
+	work[t].deals = deals;
+	work[t].score = score + t * n;
+    }
+    runthreads(montework, work, sizeof(struct MonteWork), threads);
+
+    for (t = 1; t < threads; t++)
+	for (i = 0; i < n; i++) score[i] += score[t * n + i];
+    for (best = 0, i = 1; i < n; i++) if (score[i] < score[best]) best = i;
+    *pick = moves[best].cards;
+    v = moves[best].value;
+    free(score);
+    free(moves);
+    return v;
+}
+
+/* information set Monte Carlo tree search.  each thread grows a tree of
+its own over the plays open to every hand, each time down it with a new
+deal of the cards unseen by the searching hand, and only the plays legal
+in that deal are open.  the threads' counts at the root are added up to
+choose.  a node is known by what the searching hand can see there, so the
+next search takes up the part of the tree under the plays made since. */
+
+#define UCTC		0.7	/* how far to look at plays tried less */
+#define MAXPATH		512	/* plays down the tree in one game */
+#define HASHSIZE	32768	/* a power of 2 above MAXMOVES */
+#define CLOCKEVERY	16	/* deals between looks at the clock */
+
+struct TreeNode
+{
+    cardmask move;		/* the play that led here, 0 for a pass */
+    unsigned long long key;	/* what the searching hand sees here */
+    int child, next;		/* the first child and the next sibling */
+    int mover;			/* the hand that made the play */
+    unsigned int visits, avail;	/* times chosen, times it could have been */
+    double reward;		/* the mover's rewards, added up */
+};
+
+/* a flag one thread sets for another to stop by */
+struct StopFlag
+{
+    pthread_mutex_t lock;
+    int set;
+};
+
+/* one thread's share of a search */
+struct TreeWork
+{
+    struct GameState *g;
+    struct SearchTree *t;	/* the first of its trees */
+    int trees;			/* grown in turn, CLOCKEVERY deals each */
+    int who;			/* the searching hand */
+    int size, iterations;
+    double deadline;		/* wallclock() to stop at, 0 for none */
+    struct StopFlag *stop;	/* set to stop, if not NULL */
+    int untilfull;		/* stop once its trees have no room left */
+};
+
+/* what hand who sees of where g stands:  its own cards, the cards thrown,
+how many each one holds and the turn state */
+static unsigned long long seenkey(struct GameState *g, int who)
+{
+    unsigned long long k;
+    int i;
+
+    k = mixkey(g->hand[who].key ^ who) ^ g->hand[MAXPLAYERS].key ^ 
+	mixkey(g->betterthis ^ ((unsigned long long)g->turn << 32) ^ 
+	((unsigned long long)g->firstdrop << 36) ^
+	((unsigned long long)(g->lastthrow + 1) << 40) ^
+	((unsigned long long)g->cntrlflag << 48));
+    for (i = 0; i < g->numplayers; i++)
+	k = mixkey(k ^ ((unsigned long long)g->hand[i].held << 56));
+    return k;
+}
+
+static int newnode(struct SearchTree *t, cardmask move, int mover, 
+    unsigned long long key)
+{
+    struct TreeNode *p = t->node + t->used;
+
+    p->move = move;
+    p->key = key;
+    p->child = p->next = -1;
+    p->mover = mover;
+    p->visits = p->avail = 0;
+    p->reward = 0;
+    return t->used++;
+}
+
+/* copies node i of from, and all under it, to the end of to */
+static int copytree(struct SearchTree *to, struct TreeNode *from, int i)
+{
+    int n = to->used++, c, k, last = -1;
+
+    to->node[n] = from[i];
+    to->node[n].child = -1;
+    for (c = from[i].child; c >= 0; c = from[c].next)
+    {
+	k = copytree(to, from, c);
+	if (last < 0) to->node[n].child = k;
+	else to->node[last].next = k;
+	last = k;
+    }
+    to->node[n].next = -1;
+    return n;
+}
+
+/* makes the node seen as key the root of t, keeping what is under it, or
+starts t afresh.  returns 0 if there is no room for the tree. */
+static int keeptree(struct SearchTree *t, int size, unsigned long long key)
+{
+    struct SearchTree n;
+    int i;
+
+    if (!t->node)
+    {
+	if (!(t->node = malloc(size * sizeof(struct TreeNode)))) return 0;
+	t->used = 0;
+    }
+    for (i = 0; (i < t->used) && (t->node[i].key != key); i++);
+    if (i == 0) 
+    {
+	if (t->used) return 1;
+    }
+    else if ((i < t->used) && 
+	(n.node = malloc(size * sizeof(struct TreeNode))))
+    {
+	n.used = 0;
+	copytree(&n, t->node, i);
+	free(t->node);
+	t->node = n.node;
+	t->used = n.used;
+	return 1;
+    }
+    t->used = 0;
+    newnode(t, 0, -1, key);
+    return 1;
+}
+
+/* plays combo in d, noting the place of a hand that goes out by it */
+static void treeplay(struct GameState *d, cardmask combo, int *place, 
+    int *out)
+{
+    int i;
+
+    if (!playmove(d, combo)) enginefatal("ismcts tried an illegal play");
+    for (i = 0; i < d->numplayers; i++)
+	if ((place[i] == -1) && (d->hand[i].held == 60)) place[i] = (*out)++;
+}
+
+/* one deal, down the tree and played out.  each hand still in scores 1 for
+going out first down to 0 for being left with its cards.  slot[] and 
+stamp[] are a table of the legal plays by their cards, stamped gen. */
+static void iterate(struct TreeWork *w, struct MoveStruct *moves, 
+    int *slot, unsigned int *stamp, unsigned int *gen)
+{
+    struct SearchTree *t = w->t;
+    struct TreeNode *p;
+    struct GameState d = *w->g;
+    int path[MAXPATH], place[MAXPLAYERS];
+    double best, v;
+    cardmask pick;
+    unsigned int h;
+    int i, c, n, k, in, out = 0, depth = 0, node = 0, who = w->who;
+
+    determinize(&d, who, &t->seed, moves);
+    for (in = 0, i = 0; i < d.numplayers; i++)
+    {
+	place[i] = (d.hand[i].held == 60) ? -2 : -1;
+	if (d.hand[i].held != 60) in++;
+    }
+
+    /* down the tree while every play legal in this deal has been tried */
+    while ((node >= 0) && !onehaslost(&d) && (depth < MAXPATH))
+    {
+	n = plays(&d, moves);
+	(*gen)++;
+	for (i = 0; i < n; i++)
+	{
+	    for (h = mixkey(moves[i].cards) & (HASHSIZE - 1); stamp[h] == *gen;
+		h = (h + 1) & (HASHSIZE - 1));
+	    stamp[h] = *gen; slot[h] = i;
+	    moves[i].value = 0;		/* 1 once it has a child */
+	}
+	for (k = -1, best = -1, c = t->node[node].child; c >= 0; 
+	    c = t->node[c].next)
+	{
+	    p = t->node + c;
+	    for (h = mixkey(p->move) & (HASHSIZE - 1); (stamp[h] == *gen) &&
+		(moves[slot[h]].cards != p->move); h = (h + 1) & (HASHSIZE - 1));
+	    if (stamp[h] != *gen) continue;
+	    moves[slot[h]].value = 1;
+	    p->avail++;
+	    v = p->reward / p->visits + UCTC * sqrt(log(p->avail) / p->visits);
+	    if (v > best)
+	    {
+		best = v; k = c;
+	    }
+	}
+	for (c = 0, i = 0; i < n; i++) if (!moves[i].value) c++;
+	if (c && (t->used < w->size))
+	{
+	    /* a play not tried yet, at random, as a new leaf */
+	    for (c = nextrand(&t->seed) % c, i = 0; moves[i].value || c--; i++);
+	    k = newnode(t, moves[i].cards, d.turn, 0);
+	    treeplay(&d, moves[i].cards, place, &out);
+	    p = t->node + k;
+	    p->key = seenkey(&d, who);
+	    p->next = t->node[node].child;
+	    t->node[node].child = k;
+	    p->avail = 1;
+	    path[depth++] = k;
+	    break;
+	}
+	if (k < 0) break;
+	treeplay(&d, t->node[k].move, place, &out);
+	path[depth++] = node = k;
+    }
+
+    /* the rest of the game as makechoice() would play it */
+    while (!onehaslost(&d))
+    {
+	makechoice(&d, d.turn, d.firstdrop, d.betterthis, &pick);
+	treeplay(&d, pick, place, &out);
+    }
+    for (i = 0; i < d.numplayers; i++) if (place[i] == -1) place[i] = out;
+    while (depth--)
+    {
+	p = t->node + path[depth];
+	p->visits++;
+	p->reward += (double)(in - 1 - place[p->mover]) / (in - 1);
+    }
+}
+
+static int stopped(struct StopFlag *f)
+{
+    int set;
+
+    if (!f) return 0;
+    pthread_mutex_lock(&f->lock);
+    set = f->set;
+    pthread_mutex_unlock(&f->lock);
+    return set;
+}
+
+/* 1 if none of w's trees has room for another node */
+static int treesfull(struct TreeWork *w)
+{
+    int t;
+
+    for (t = 0; t < w->trees; t++) if (w->t[t].used < w->size) return 0;
+    return 1;
+}
+
+static void *treework(void *arg)
+{
+    struct TreeWork *w = arg;
+    struct GameState g = *w->g;
+    struct TreeWork mine = *w;
+    struct ChoiceCache cache;
+    struct ChoiceEntry *slots;
+    struct MoveStruct *moves;
+    unsigned int *stamp, gen = 0;
+    int *slot, i;
+
+    moves = malloc((MAXMOVES + 1) * sizeof(struct MoveStruct));
+    slot = malloc(HASHSIZE * sizeof(int));
+    stamp = calloc(HASHSIZE, sizeof(unsigned int));
+    if ((slots = malloc(CACHESLOTS * sizeof(struct ChoiceEntry))))
+	initcache(&cache, slots, CACHESLOTS);
+    g.cache = slots ? &cache : NULL;
+    /* the rollouts keep makechoice()'s greedy play:  planned ones cost
+    more per rollout, so there are fewer, and they played no better */
+    g.planner = NULL;
+    mine.g = &g;
+    if (moves && slot && stamp)
+	for (i = 0; (i < w->iterations) && ((i % CLOCKEVERY) || 
+	    ((!w->deadline || (wallclock() < w->deadline)) &&
+	    !stopped(w->stop) && (!w->untilfull || !treesfull(w)))); i++)
+	{
+	    mine.t = w->t + (i / CLOCKEVERY) % w->trees;
+	    iterate(&mine, moves, slot, stamp, &gen);
+	}
+    free(slots);
+    free(stamp);
+    free(slot);
+    free(moves);
+    return NULL;
+}
+
+/* sets up s to search with threads trees (one a processor if 0) of size
+nodes each.  the trees are made when first searched */
+void initsearcher(struct Searcher *s, int threads, int size)
+{
+    int t;
+
+    s->threads = numthreads(threads);
+    s->size = size;
+    s->kept = 0;
+    s->ponder = NULL;
+    for (t = 0; t < MAXTHREADS; t++)
+    {
+	s->tree[t].node = NULL;
+	s->tree[t].used = 0;
+	s->tree[t].seed = t;
+    }
+}
+
+void freesearcher(struct Searcher *s)
+{
+    int t;
+
+    stopponder(s);
+    for (t = 0; t < MAXTHREADS; t++)
+    {
+	free(s->tree[t].node);
+	s->tree[t].node = NULL;
+	s->tree[t].used = 0;
+    }
+}
+
+/* the choice of an ISMCTS player for the hand whose turn it is in g, g's
+turn state being kept as playmove() keeps it.  s keeps the trees of that
+hand from one of its turns to the next.  iterations deals are shared out
+over the trees, or as many as there is time for before deadline (by 
+wallclock(), 0 for none) if that comes first, and the play chosen most 
+often at their roots wins, or makechoice()'s if no deal was done.  puts
+its cards in *pick and returns its value, or 0 to pass. */
+comboval ismcts(struct GameState *g, struct Searcher *s, int iterations,
+    double deadline, cardmask *pick)
+{
+    struct TreeWork work[MAXTHREADS];
+    struct MoveStruct *moves;
+    struct TreeNode *p;
+    unsigned long long key = seenkey(g, g->turn);
+    unsigned int *visits;
+    int i, c, t, n, threads = s->threads, best;
+    comboval v;
+
+    *pick = 0;
+    if (!(moves = malloc((MAXMOVES + 1) * sizeof(struct MoveStruct))))
+	return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+    if ((n = plays(g, moves)) < 2)
+    {
+	v = n ? moves[0].value : 0;
+	if (n) *pick = moves[0].cards;
+	free(moves);
+	return v;
+    }
+
+    s->kept = 0;
+    if (threads > iterations) threads = iterations > 0 ? iterations : 1;
+    for (t = 0; t < threads; t++)
+    {
+	if (!keeptree(&s->tree[t], s->size, key))
+	{
+	    free(moves);
+	    return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+	}
+	s->kept += s->tree[t].used - 1;
+	work[t].g = g;
+	work[t].t = &s->tree[t];
+	work[t].trees = 1;
+	work[t].who = g->turn;
+	work[t].size = s->size;
+	work[t].iterations = iterations / threads + (t < iterations % threads);
+	work[t].deadline = deadline;
+	work[t].stop = NULL;
+	work[t].untilfull = 0;
+    }
+    runthreads(treework, work, sizeof(struct TreeWork), threads);
+
+    /* the visits of each play, over all the trees */
+    if (!(visits = calloc(n, sizeof(unsigned int))))
+    {
+	free(moves);
+	return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+    }
+    for (t = 0; t < threads; t++)
+	for (c = s->tree[t].node[0].child; c >= 0; c = p->next)
+	{
+	    p = s->tree[t].node + c;
+	    for (i = 0; (i < n) && (moves[i].cards != p->move); i++);
+	    if (i < n) visits[i] += p->visits;
+	}
+    for (best = 0, i = 1; i < n; i++) if (visits[i] > visits[best]) best = i;
+    /* no deal done in the time, so nothing to go by */
+    if (!visits[best])
+    {
+	free(visits);
+	free(moves);
+	return makechoice(g, g->turn, g->firstdrop, g->betterthis, pick);
+    }
+    *pick = moves[best].cards;
+    v = moves[best].value;
+    free(visits);
+    free(moves);
+    return v;
+}
+
+/* pondering:  an ISMCTS player going on with its trees on a thread of its
+own while another hand is to play, from where it sees the game then.  the
+plays that hand makes are in the trees by the time its own turn comes, so
+ismcts() takes up what was found under them. */
+struct PonderWork
+{
+    pthread_t tid;
+    struct GameState g;		/* the game as it was, kept for the thread */
+    struct TreeWork work;
+    struct StopFlag stop;
+};
+
+static void *ponderwork(void *arg)
+{
+    return treework(&((struct PonderWork *)arg)->work);
+}
+
+/* starts s pondering on g for hand who, until stopponder(), deadline (by
+wallclock(), 0 for none) or its trees are full.  g is copied and may be changed after.  
+returns 0 if it could not start, as when s is pondering already. */
+int startponder(struct GameState *g, struct Searcher *s, int who,
+    double deadline)
+{
+    struct PonderWork *p;
+    unsigned long long key = seenkey(g, who);
+    int t, ok;
+
+    if (s->ponder || onehaslost(g) || (g->hand[who].held == 60) ||
+	!(p = malloc(sizeof(struct PonderWork))))
+	return 0;
+    for (t = 0; (t < s->threads) && keeptree(&s->tree[t], s->size, key);
+	t++);
+    p->g = *g;
+    pthread_mutex_init(&p->stop.lock, NULL);
+    p->stop.set = 0;
+    p->work.g = &p->g;
+    p->work.t = s->tree;
+    p->work.trees = t;
+    p->work.who = who;
+    p->work.size = s->size;
+    p->work.iterations = INT_MAX;
+    p->work.deadline = deadline;
+    p->work.stop = &p->stop;
+    p->work.untilfull = 1;
+    ok = t && !pthread_create(&p->tid, NULL, ponderwork, p);
+    if (!ok)
+    {
+	pthread_mutex_destroy(&p->stop.lock);
+	free(p);
+	return 0;
+    }
+    s->ponder = p;
+    return 1;
+}
+
+/* stops s pondering, if it is, and waits for the thread to be done */
+void stopponder(struct Searcher *s)
+{
+    if (!s->ponder) return;
+    pthread_mutex_lock(&s->ponder->stop.lock);
+    s->ponder->stop.set = 1;
+    pthread_mutex_unlock(&s->ponder->stop.lock);
+    pthread_join(s->ponder->tid, NULL);
+    pthread_mutex_destroy(&s->ponder->stop.lock);
+    free(s->ponder);
+    s->ponder = NULL;
+}
+
+/* exact play of endings between two hands.  once only two hands are left
+and every card not in the one to play and not thrown has to be in the 
+other, nothing is hidden, and whoever can force going out first wins.
+the search is an AND/OR one over the plays of each, with a table of the
+positions solved, kept from one solve to the next. */
+
+#define SOLVECLOCK	1024	/* positions between looks at the clock */
+
+/* the most plays genmoves() puts down for a hand of h cards before it
+keeps the legal ones:  every set of 1, 2, 3 or 5 */
+static int candidates(int h)
+{
+    return h + h * (h - 1) / 2 + h * (h - 1) * (h - 2) / 6 +
+	h * (h - 1) * (h - 2) * (h - 3) / 24 * (h - 4) / 5;
+}
+
+/* sets up s with a table of n (rounded down to a power of 2) positions, 
+to give up on a solve after maxnodes positions.  returns 0 if there is 
+no room for it */
+int initsolver(struct Solver *s, int n, unsigned long maxnodes)
+{
+    int i;
+
+    for (s->size = 1; s->size * 2 <= n; s->size *= 2);
+    s->room = 4 * MAXMOVES;
+    s->slot = malloc(s->size * sizeof(struct SolveEntry));
+    s->moves = malloc(s->room * sizeof(struct MoveStruct));
+    if (!s->slot || !s->moves)
+    {
+	freesolver(s);
+	return 0;
+    }
+    for (i = 0; i < s->size; i++) s->slot[i].key = 0;
+    s->maxnodes = maxnodes;
+    s->deadline = 0;
+    s->nodes = 0;
+    s->secs = 0;
+    return 1;
+}
+
+void freesolver(struct Solver *s)
+{
+    free(s->slot);
+    free(s->moves);
+    s->slot = NULL;
+    s->moves = NULL;
+}
+
+/* the other hand left in g when only two are, or -1 */
+static int otherhand(struct GameState *g)
+{
+    int i, o = -1;
+
+    for (i = 0; i < g->numplayers; i++)
+	if ((i != g->turn) && (g->hand[i].held != 60))
+	{
+	    if (o >= 0) return -1;
+	    o = i;
+	}
+    return o;
+}
+
+/* 1 if the hand to play in g is in a two handed ending it can see all of,
+with at most limit cards left between the two */
+int solvable(struct GameState *g, int limit)
+{
+    int o = otherhand(g);
+
+    if (o < 0) return 0;
+    return (popcount(unseen(g, g->turn)) == g->hand[o].held) &&
+	(g->hand[g->turn].held + g->hand[o].held <= limit);
+}
+
+/* 1 if the hand to play in g can force going out first.  the plays of 
+each position down the line go at s->moves + base.  sets s->gaveup if
+the search grows too big or runs past s->deadline. */
+static int wins(struct Solver *s, struct GameState *g, int base)
+{
+    struct SolveEntry *e;
+    struct MoveStruct *m = s->moves + base;
+    struct GameState next;
+    unsigned long long key = gamekey(g);
+    int i, n, h = g->hand[g->turn].held, win = 0;
+
+    e = s->slot + (key & (s->size - 1));
+    if (e->key == key) return e->win;
+    if ((++s->nodes > s->maxnodes) || 
+	(base + candidates(h) + 1 > s->room) || (s->deadline &&
+	!(s->nodes % SOLVECLOCK) && (wallclock() >= s->deadline)))
+    {
+	s->gaveup = 1;
+	return 0;
+    }
+    n = genmoves(g, g->turn, g->firstdrop, g->betterthis, m);
+    /* going out ends it */
+    for (i = 0; i < n; i++) if (popcount(m[i].cards) == h) win = 1;
+    /* the 5 card plays first, as they take the most cards out, and a pass
+    last */
+    for (i = n - 1; !win && (i >= (g->firstdrop ? 0 : -1)); i--)
+    {
+	next = *g;
+	playmove(&next, (i < 0) ? 0 : m[i].cards);
+	win = !wins(s, &next, base + n);
+	if (s->gaveup) return 0;
+    }
+    e->key = key;
+    e->win = win;
+    return win;
+}
+
+/* plays the ending in g, which has to be solvable(), for the hand to play,
+putting its play in *pick (0 to pass).  returns 1 if it wins, 0 if it 
+cannot but for a mistake of the other, when the play is makechoice()'s,
+and -1 if it gave up, when the play is left to the caller.  it gives up
+after s->maxnodes positions or at deadline (by wallclock(), 0 for none),
+whichever comes first. */
+int solve(struct GameState *g, struct Solver *s, double deadline,
+    cardmask *pick)
+{
+    struct GameState d = *g, next;
+    struct MoveStruct *m = s->moves;
+    cardmask other;
+    double start = wallclock();
+    int i, n, crd, o = otherhand(g), win = 0;
+
+    *pick = 0;
+    s->nodes = 0;
+    s->gaveup = 0;
+    s->deadline = deadline;
+    /* the other hand is every card not seen */
+    emptyhand(&d, o);
+    for (other = unseen(g, g->turn); other; other &= other - 1)
+    {
+	crd = lowcard(other);
+	addcard(&d, crd, o);
+    }
+    d.cache = NULL;
+
+    n = plays(&d, m);
+    for (i = 0; !win && (i < n); i++)
+    {
+	next = d;
+	playmove(&next, m[i].cards);
+	if ((next.hand[g->turn].held == 60) || !wins(s, &next, n))
+	{
+	    win = 1;
+	    *pick = m[i].cards;
+	}
+	if (s->gaveup) break;
+    }
+    s->secs = wallclock() - start;
+    if (s->gaveup) return -1;
+    if (!win) makechoice(&d, d.turn, d.firstdrop, d.betterthis, pick);
+    return win;
+}
@@ -0,0 +1,1123 @@
+/*
+pusoylib.c
+
+The rules of PUSOY-DOS and the AI of the computer players:  dealing, the
+value of a play, the legal plays of a hand and the choice of one.  The
+terminal game in pusoy.c is built on it; see pusoy.h.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+/* playvalues() has an AVX2 version, chosen at run time where the compiler
+can build it for any x86 */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+#define SIMD5
+#include <immintrin.h>
+#endif
+#include "pusoy.h"
+#include "pusoytab.h"
+
+char *kindname[] = { "nothing", "a single card", "a pair", "a trio", 
+    "a straight", "a flush", "a full house", "a four of a kind", 
+    "a straight flush", "a royal flush" };
+
+static void deffatal(char *s)
+{
+    (void)fprintf(stderr, "pusoy:  fatal error:  %s\n", s);
+    abort();
+}
+
+void (*enginefatal)(char *s) = deffatal;
+
+static void fatal(char *s)
+{
+    enginefatal(s);
+}
+
+int popcount(cardmask m)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(m);
+#else
+    int n = 0;
+
+    for (; m; m &= m - 1) n++;
+    return n;
+#endif
+}
+
+/* the lowest card in a non-empty mask */
+int lowcard(cardmask m)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(m);
+#else
+    int n = 0;
+
+    while (!(m & 1))
+    {
+	m >>= 1; n++;
+    }
+    return n;
+#endif
+}
+
+/* the highest card in a non-empty mask */
+static int highcard(cardmask m)
+{
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(m);
+#else
+    int n = 63;
+
+    while (!(m & CARDBIT(63)))
+    {
+	m <<= 1; n--;
+    }
+    return n;
+#endif
+}
+
+/* fills deck[] with the cards in m, lowest first */
+int maskcards(cardmask m, int *deck)
+{
+    int n = 0;
+
+    for (; m; m &= m - 1) deck[n++] = lowcard(m);
+    return n;
+}
+
+/* the n lowest cards of m */
+static cardmask lowcards(cardmask m, int n)
+{
+    cardmask low = 0;
+
+    for (; m && n; n--, m &= m - 1) low |= m & -m;
+    return low;
+}
+
+/* the cards of one suit with the ranks in the bit mask ranks */
+static cardmask suitcards(int suit, int ranks)
+{
+    cardmask m = 0;
+
+    for (; ranks; ranks &= ranks - 1) m |= CARDBIT(lowcard(ranks) * 4 + suit);
+    return m;
+}
+
+void emptyhand(struct GameState *g, int who)
+{
+    int i;
+
+    g->hand[who].cards = 0;
+    g->hand[who].held = 0;
+    for (i = 0; i < 13; i++) g->hand[who].count[i] = 0;
+    for (i = 0; i < 4; i++) g->hand[who].suitranks[i] = 0;
+    g->hand[who].key = 0;
+}
+
+/* these two are the only ways a card enters or leaves a hand, so that the
+rank counts and suit masks stay in step with the cards */
+void addcard(struct GameState *g, int crd, int who)
+{
+    g->hand[who].cards |= CARDBIT(crd);
+    g->hand[who].held++;
+    g->hand[who].count[crd / 4]++;
+    g->hand[who].suitranks[crd % 4] |= 1 << (crd / 4);
+    g->hand[who].key ^= zcard[crd];
+}
+
+void removecard(struct GameState *g, int crd, int who)
+{
+    g->hand[who].cards &= ~CARDBIT(crd);
+    g->hand[who].held--;
+    g->hand[who].count[crd / 4]--;
+    g->hand[who].suitranks[crd % 4] &= ~(1 << (crd / 4));
+    g->hand[who].key ^= zcard[crd];
+}
+
+/* the cards hand who cannot see:  those not in its hand and not thrown */
+cardmask unseen(struct GameState *g, int who)
+{
+    return ~(g->hand[who].cards | g->hand[MAXPLAYERS].cards) & ALLCARDS;
+}
+
+/* a rand() of each game's own, so that games do not share one sequence */
+static int gamerand(struct GameState *g)
+{
+    g->seed = g->seed * 1103515245 + 12345;
+    return (g->seed >> 16) & 32767;
+}
+
+void shuffle(struct GameState *g)
+{
+    int i, dist, curply = 0;
+    int crdhold[NUMCARDS];
+
+    for (i = 0; i < MAXPLAYERS + 2; i++) emptyhand(g, i);
+    for (i = 0; i < NUMCARDS; i++) crdhold[i] = 0;
+    for (dist = 0; dist < NUMCARDS - g->discard; dist++) 
+    {
+	i = (i + gamerand(g)) % NUMCARDS;
+	while (crdhold[i]) i = (i + 1) % NUMCARDS;
+	crdhold[i] = 1;
+	addcard(g, i, curply);
+	curply = (curply + 1) % g->numplayers;
+    }
+}
+
+int whosfirst(struct GameState *g)
+{
+    int i, j, min;
+
+    i = 0;
+    min = lowcard(g->hand[0].cards);
+    for (j = 1; j < g->numplayers; j++)
+    {
+	if (min > lowcard(g->hand[j].cards))
+	{
+	    min = lowcard(g->hand[j].cards);
+	    i = j;
+	}
+    }
+    return i;
+}
+
+/* the ranks of a rank mask in straight order:  bit (r + 2) % 13 for rank r,
+so A 2 3 ... K are bits 0 to 12 */
+static int strtorder(int ranks)
+{
+    return ((ranks << 2) | (ranks >> 11)) & 8191;
+}
+
+/******* look for flush, straight flush and royal flush starts here *******/
+/* the first of these that beats betterthis, each taken a suit at a time:
+a flush (the four lowest of the suit and the one above them that wins, 
+rated as a flush even if they make a straight flush), a straight flush up
+to 9TJQK, a royal flush */
+static int lookforsuited(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    int suit, ranks, low, rest, strts, w;
+
+    for (suit = 0; suit < 4; suit++)
+    {
+	ranks = g->hand[who].suitranks[suit];
+	if (popcount(ranks) < 5) continue;
+	low = lowcards(ranks, 4);
+	rest = ranks & ~low;
+	if ((w = betterthis - flushkey[suit] + 1) > 0) 
+	    rest &= ~0U << (w > 13 ? 13 : w);
+	if (rest)
+	{
+	    *pick |= suitcards(suit, low | (rest & -rest));
+	    return flushkey[suit] + lowcard(rest);
+	}
+    }
+    for (suit = 0; suit < 4; suit++)
+    {
+	ranks = strtorder(g->hand[who].suitranks[suit]);
+	strts = ranks & (ranks >> 1) & (ranks >> 2) & (ranks >> 3) & 
+	    (ranks >> 4);
+	if ((w = betterthis - sfkey[suit] + 1) > 0) 
+	    strts &= ~0U << (w > 13 ? 13 : w);
+	if (strts)
+	{
+	    w = lowcard(strts);
+	    *pick |= suitcards(suit, strtwin[w]);
+	    return sfkey[suit] + w;
+	}
+    }
+    for (suit = 0; suit < 4; suit++)
+	if (((g->hand[who].suitranks[suit] & strtwin[9]) == strtwin[9]) && 
+	    (royalkey[suit] > betterthis))
+	{
+	    *pick |= suitcards(suit, strtwin[9]);
+	    return royalkey[suit];
+	}
+    return 0;
+}
+/******* look for flush, straight flush and royal flush ends here *******/
+
+/******* look for four-of-a-kind starts here *******/
+static int lookfor4(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    int i, number = -1, kicker = -1;
+    int single=-1, pair=-1, trio=-1, quad=-1;
+    unsigned char *list = g->hand[who].count;
+
+    for (i=0; i<13; i++)
+    {
+	if ((list[i] == 4) && (i > (betterthis - keybase[FOURKIND]))) 
+	{
+	    number = i;
+	    break;
+	}
+    }
+    if (number < 0) return 0;
+    *pick |= RANKCARDS(number);
+    for (i=0; i<13; i++)
+    {
+	switch (list[i])
+	{
+	    case 1:
+		if (single < 0) single = i; 
+		break;
+	    case 2: 
+		if (pair < 0) pair = i; 
+		break;
+	    case 3: 
+		if (trio < 0) trio = i; 
+		break;
+	    case 4: 
+		if ((quad < 0) && (i != number)) quad = i; 
+		break;
+	}
+    }
+    if ((single > 7) && (pair >= 0) && ((single-pair) >= 4)) kicker = pair;
+    else if (single >= 0) kicker = single;
+    else if (pair >= 0) kicker = pair;
+    else if (trio >= 0) kicker = trio;
+    else if (quad >= 0) kicker = quad;
+    if (kicker >= 0) 
+	*pick |= lowcards(g->hand[who].cards & RANKCARDS(kicker), 1);
+    return keybase[FOURKIND] + number;
+}
+/******* look for four-of-a-kind ends here *******/ 
+
+static int lookforfull(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    unsigned char *LIST = g->hand[who].count;
+    int trio = -1, duo = -1;
+    int i = 0;
+    int stat3 = 0;
+    int stat2 = -1, stat2by3 =-1, stat2by4 = -1;
+
+    for (i=0; i<13; i++)
+    {
+	if ((LIST[i] == 3) && (i > betterthis - keybase[FULLHOUSE]))  
+	{
+	    trio = i; stat3 = 1; break;
+	}
+	
+    }
+    if (stat3==0) 
+    {
+	for (i=0; i < 13; i++)
+	{
+	    if ((LIST[i] == 4) && (i > (betterthis - keybase[FULLHOUSE])))
+	    {
+		trio = i; break;
+	    }
+	}
+    } /* end stat3==0 */
+    if (trio < 0) return 0;
+    for (i=0; i < 13; i++)
+    {
+        if ((LIST[i] == 2) && (stat2 < 0)) stat2 = i;
+	if ((LIST[i] == 3) && (stat2by3 < 0) && (i != trio)) stat2by3 = i;
+	if ((LIST[i] == 4) && (stat2by4 < 0) && (i != trio)) stat2by4 = i;
+    }
+    if ((stat2 > 7) && (stat2by3 > -1) && (stat2by3 < (stat2-4))) 
+	duo = stat2by3;
+    else if (stat2 > -1)    duo = stat2;
+    else if (stat2by3 > -1) duo = stat2by3;
+    else if (stat2by4 > -1) duo = stat2by4;
+
+    if ((trio >= 0) && (duo >= 0)) 
+    {
+	*pick |= lowcards(g->hand[who].cards & RANKCARDS(trio), 3) |
+	    lowcards(g->hand[who].cards & RANKCARDS(duo), 2);
+	return (keybase[FULLHOUSE] + trio);
+    }
+    return 0;
+}
+
+/* straight w (0 for A2345 up to 8 for 9TJQK and 9 for TJQKA) runs from
+bit w of the straight order and tops with rank w + 2 */
+static int lookforstraight(struct GameState *g, int who, int betterthis,
+    cardmask *pick) 
+{
+    struct DeckStruct *h = &g->hand[who];
+    unsigned int run, strts, win;
+    int w, j, r;
+    cardmask top;
+
+    run = strtorder(h->suitranks[0] | h->suitranks[1] | h->suitranks[2] |
+	h->suitranks[3]);
+    strts = run & (run >> 1) & (run >> 2) & (run >> 3) & (run >> 4);
+    win = strts;
+    if ((((run >> 9) & 15) == 15) && (run & 1)) win |= 1 << 9;
+    for (; win; win &= win - 1)
+    {
+	w = lowcard(win);
+	if (strtkey[w][3] <= betterthis) continue;
+	for (top = h->cards & RANKCARDS(w + 2); top; top &= top - 1)
+	    if (strtkey[w][lowcard(top) % 4] > betterthis) break;
+	if (!top) continue;
+	*pick |= top & -top;
+	/* below the top, a rank that topped a straight already tried goes
+	with its highest card, any other with its lowest */
+	for (j = 0; j < 4; j++)
+	{
+	    r = (w + j + 11) % 13;
+	    if ((w + j >= 4) && (strts & (1 << (w + j - 4))))
+		*pick |= CARDBIT(highcard(h->cards & RANKCARDS(r)));
+	    else *pick |= CARDBIT(lowcard(h->cards & RANKCARDS(r)));
+	}
+	return strtkey[w][lowcard(top) % 4];
+    }
+    return 0;
+}
+
+/******* five card combination table starts here *******/
+/* every 5 card set has a slot in combo5[], found by its rank in the
+combinatorial number system, holding the set's value on the betterthis
+scale (see lookfor5) or 0 if the set is not a valid play */
+#define NUMCOMBO5	2598960		/* 52 choose 5 */
+/* 4 spare slots, always 0:  one for sets that are not 5 cards, and room 
+for playvalues() to read a whole int at the last one */
+static unsigned char combo5[NUMCOMBO5 + 4];
+
+#ifdef SIMD5
+/* combo5index() a byte of the mask at a time:  byte5[b][p][x] is what
+byte b holding x adds to the index of a set with p cards below it (up to
+5) in the bits from 3 up, and the cards of x in the low 3 */
+static unsigned int byte5[7][6][256];
+static int avx2;		/* if the processor has it */
+#endif
+
+static int combo5index(cardmask m)
+{
+    int i, idx = 0;
+
+    for (i = 1; i <= 5; i++)
+    {
+	idx += choose[lowcard(m)][i];
+	m &= m - 1;
+    }
+    return idx;
+}
+
+/* value of the 5 cards in c[], sorted ascending */
+static int classify5(int *c)
+{
+    int i, w, flush = 1, count[13], trio = -1, pair = -1, quad = -1;
+    int ranks = 0;
+
+    for (i = 0; i < 13; i++) count[i] = 0;
+    for (i = 0; i < 5; i++)
+    {
+	count[c[i] / 4]++;
+	if ((c[i] % 4) != (c[0] % 4)) flush = 0;
+	ranks |= 1 << (c[i] / 4);
+    }
+    for (i = 0; i < 13; i++) switch (count[i])
+    {
+	case 4: quad = i; break;
+	case 3: trio = i; break;
+	case 2: pair = i; break;
+    }
+    if (quad >= 0) return keybase[FOURKIND] + quad;
+    if ((trio >= 0) && (pair >= 0)) return keybase[FULLHOUSE] + trio;
+    if ((trio >= 0) || (pair >= 0)) return 0;
+
+    /* five different ranks:  straight w if they are strtwin[w] */
+    for (w = 0; (w < 10) && (strtwin[w] != ranks); w++);
+    if (flush)
+    {
+	if (w == 9) return royalkey[c[0] % 4];
+	if (w < 9) return sfkey[c[0] % 4] + w;
+	return flushkey[c[0] % 4] + c[4] / 4;
+    }
+    if (w == 10) return 0;
+    for (i = 0; c[i] / 4 != w + 2; i++);
+    return strtkey[w][c[i] % 4];
+}
+
+void initcombo5()
+{
+    int c[5];
+#ifdef SIMD5
+    int b, p, x, k, j;
+    unsigned int add;
+
+    for (b = 0; b < 7; b++) for (p = 0; p < 6; p++) for (x = 0; x < 256; x++)
+    {
+	for (add = 0, k = p, j = 0; j < 8; j++) if (x & (1 << j))
+	    if ((++k <= 5) && (b * 8 + j < NUMCARDS)) 
+		add += choose[b * 8 + j][k];
+	byte5[b][p][x] = (add << 3) | popcount(x);
+    }
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    for (c[4] = 4; c[4] < NUMCARDS; c[4]++)
+    for (c[3] = 3; c[3] < c[4]; c[3]++)
+    for (c[2] = 2; c[2] < c[3]; c[2]++)
+    for (c[1] = 1; c[1] < c[2]; c[1]++)
+    for (c[0] = 0; c[0] < c[1]; c[0]++)
+	combo5[choose[c[0]][1] + choose[c[1]][2] + choose[c[2]][3] +
+	    choose[c[3]][4] + choose[c[4]][5]] = classify5(c);
+}
+
+/* value of a set of cards as a play, 0 if it is not one */
+comboval playvalue(cardmask m)
+{
+    switch (popcount(m))
+    {
+	case 1:
+	    return COMBOVAL(1, SINGLE, lowcard(m) + 1);
+	case 2:
+	    if (lowcard(m) / 4 != highcard(m) / 4) break;
+	    return COMBOVAL(2, PAIR, highcard(m));
+	case 3:
+	    if (lowcard(m) / 4 != highcard(m) / 4) break;
+	    return COMBOVAL(3, TRIO, lowcard(m) / 4 + 1);
+	case 5:
+	    return scale5[combo5[combo5index(m)]];
+    }
+    return 0;
+}
+
+#ifdef SIMD5
+/* playvalues() 8 sets at a time:  the index of each set is added up from
+byte5[] a byte at a time, and looked up in combo5[] and scale5[] */
+__attribute__((target("avx2")))
+static int playvalues8(cardmask *sets, comboval *out, int n)
+{
+    __m256i a, b, lo, hi, x, e, p, idx, v, five = _mm256_set1_epi32(5);
+    __m256i odd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i byte = _mm256_set1_epi32(255), seven = _mm256_set1_epi32(7);
+    int i, j, k, none;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+	/* the low and the high 32 bits of the 8 masks */
+	a = _mm256_permutevar8x32_epi32(
+	    _mm256_loadu_si256((__m256i *)(sets + i)), odd);
+	b = _mm256_permutevar8x32_epi32(
+	    _mm256_loadu_si256((__m256i *)(sets + i + 4)), odd);
+	lo = _mm256_permute2x128_si256(a, b, 0x20);
+	hi = _mm256_permute2x128_si256(a, b, 0x31);
+	p = idx = _mm256_setzero_si256();
+	for (k = 0; k < 7; k++)
+	{
+	    x = _mm256_and_si256(_mm256_srli_epi32((k < 4) ? lo : hi,
+		(k % 4) * 8), byte);
+	    /* byte5[k][min(p, 5)][x] */
+	    e = _mm256_add_epi32(_mm256_slli_epi32(_mm256_add_epi32(
+		_mm256_set1_epi32(k * 6), _mm256_min_epu32(p, five)), 8), x);
+	    e = _mm256_i32gather_epi32((int *)byte5, e, 4);
+	    p = _mm256_add_epi32(p, _mm256_and_si256(e, seven));
+	    idx = _mm256_add_epi32(idx, _mm256_srli_epi32(e, 3));
+	}
+	/* not 5 cards:  the spare slot, and playvalue() after */
+	none = _mm256_movemask_ps(_mm256_castsi256_ps(
+	    _mm256_cmpeq_epi32(p, five))) ^ 255;
+	idx = _mm256_blendv_epi8(_mm256_set1_epi32(NUMCOMBO5), idx,
+	    _mm256_cmpeq_epi32(p, five));
+	v = _mm256_i32gather_epi32((int *)combo5, idx, 1);
+	v = _mm256_and_si256(v, byte);
+	v = _mm256_i32gather_epi32((int *)scale5, v, 4);
+	_mm256_storeu_si256((__m256i *)(out + i), v);
+	for (j = 0; none; j++, none >>= 1)
+	    if (none & 1) out[i + j] = playvalue(sets[i + j]);
+    }
+    return i;
+}
+#endif
+
+/* out[i] = playvalue(sets[i]) for n sets, 8 at a time with AVX2 where the
+processor has it */
+void playvalues(cardmask *sets, comboval *out, int n)
+{
+    int i = 0;
+
+#ifdef SIMD5
+    if (avx2) i = playvalues8(sets, out, n);
+#endif
+    for (; i < n; i++) out[i] = playvalue(sets[i]);
+}
+#undef NUMCOMBO5
+/******* five card combination table ends here *******/
+
+static int lookfor5(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    int i, j;
+    cardmask suited = 0;
+    /* better this:
+	straight 	1 ... 40
+	flush		41 ... 72
+	full house 	73 ... 85
+	four of a kind	86 ... 98
+	straight flush  99 ... 134
+	royal flush	135 ... 138 */
+
+    if (g->hand[who].held < 5) return 0;
+
+    if ((i = lookforstraight(g, who, betterthis, pick))) return i;
+    /* a suited play beyond a flush comes after full houses and fours */
+    if ((i = lookforsuited(g, who, betterthis, &suited)) && 
+	(i < keybase[FULLHOUSE]))
+    {
+	*pick |= suited;
+	return i;
+    }
+    if ((j = lookforfull(g, who, betterthis, pick))) return j;
+    if ((j = lookfor4(g, who, betterthis, pick))) return j;
+    *pick |= suited;
+    return i;
+}
+
+static int lookfor3(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    int rank;
+
+    for (rank = 0; rank < 13; rank++) 
+	if ((g->hand[who].count[rank] >= 3) && ((rank + 1) > betterthis))
+	{
+	    *pick |= lowcards(g->hand[who].cards & RANKCARDS(rank), 3);
+	    return rank + 1;
+	}
+    return 0;
+}
+
+static int lookfor2(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    int rank;
+    cardmask m;
+
+    /* the lowest card of a rank goes with the first one above betterthis,
+    since the value of a pair is that of its higher card */
+    for (rank = 0; rank < 13; rank++) if (g->hand[who].count[rank] >= 2)
+    {
+	m = g->hand[who].cards & RANKCARDS(rank);
+	for (m &= m - 1; m; m &= m - 1) if (lowcard(m) > betterthis)
+	{
+	    *pick |= CARDBIT(lowcard(g->hand[who].cards & 
+		RANKCARDS(rank))) | CARDBIT(lowcard(m));
+	    return lowcard(m);
+	}
+    }
+    return 0;
+}
+
+static int lookfor1(struct GameState *g, int who, int betterthis,
+    cardmask *pick)
+{
+    cardmask above;
+
+    /* the cards whose value (card + 1) beats betterthis */
+    if (betterthis >= NUMCARDS) return 0;
+    above = g->hand[who].cards & ~(CARDBIT(betterthis) - 1);
+    if (!above) return 0;
+    *pick |= CARDBIT(lowcard(above));
+    return lowcard(above) + 1;
+}
+
+/* moves card crd out of hand who into the last play and the discards */
+void dropcard(struct GameState *g, int crd, int who)
+{
+    removecard(g, crd, who);
+    addcard(g, crd, MAXPLAYERS + 1);
+    addcard(g, crd, MAXPLAYERS);
+}
+
+/* call this when really ready to drop a combo... after validations etc. */
+void dropcombo(struct GameState *g, int who, cardmask combo)
+{
+    emptyhand(g, MAXPLAYERS + 1);
+    for (; combo; combo &= combo - 1) dropcard(g, lowcard(combo), who);
+}
+
+/******* legal move generator starts here *******/
+/* fills out[] with all k card subsets of m */
+static int picks(cardmask m, int k, cardmask got, cardmask *out)
+{
+    int n = 0;
+    cardmask c;
+
+    if (!k)
+    {
+	*out = got;
+	return 1;
+    }
+    while (popcount(m) >= k)
+    {
+	c = m & -m;
+	m ^= c;
+	n += picks(m, k - 1, got | c, out + n);
+    }
+    return n;
+}
+
+/* one card of each of the ranks rank[k..4] on top of got */
+static int strtpicks(cardmask *rank, int k, cardmask got, cardmask *out)
+{
+    int n = 0;
+    cardmask m;
+
+    if (k == 5)
+    {
+	*out = got;
+	return 1;
+    }
+    for (m = rank[k]; m; m &= m - 1) 
+	n += strtpicks(rank, k + 1, got | (m & -m), out + n);
+    return n;
+}
+
+/* puts the legal plays for hand who into moves[], which must have room 
+for MAXMOVES.  with firstdrop any opening play goes (one with the lowest 
+card if firstdrop is 2), otherwise only plays of as many cards as the last
+one.  all of them beat betterthis. */
+int genmoves(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, struct MoveStruct *moves)
+{
+    cardmask cards = g->hand[who].cards, rank[13], win[5], sub[1287];
+    cardmask trio[4], duo[6];
+    int i, j, k, t, d, n = 0, size;
+
+    size = firstdrop ? 0 : g->hand[MAXPLAYERS + 1].held;
+    for (i = 0; i < 13; i++) rank[i] = cards & ((cardmask)15 << (i * 4));
+
+    if (!size || (size == 1)) for (i = 0; i < NUMCARDS; i++) 
+	if (cards & CARDBIT(i)) moves[n++].cards = CARDBIT(i);
+    if (!size || (size == 2)) for (i = 0; i < 13; i++)
+	for (k = picks(rank[i], 2, 0, sub), j = 0; j < k; j++) 
+	    moves[n++].cards = sub[j];
+    if (!size || (size == 3)) for (i = 0; i < 13; i++)
+	for (k = picks(rank[i], 3, 0, sub), j = 0; j < k; j++) 
+	    moves[n++].cards = sub[j];
+    if (!size || (size == 5))
+    {
+	/* straights and straight flushes, A2345 up to TJQKA */
+	for (i = 0; i < 10; i++)
+	{
+	    for (j = 0; j < 5; j++) win[j] = rank[(i + j + 11) % 13];
+	    for (j = 0; j < 5; j++) if (!win[j]) break;
+	    if (j < 5) continue;
+	    for (k = strtpicks(win, 0, 0, sub), j = 0; j < k; j++)
+		moves[n++].cards = sub[j];
+	}
+	/* flushes that are not straight flushes */
+	for (i = 0; i < 4; i++)
+	    for (k = picks(cards & SUITCARDS(i), 5, 0, sub), j = 0; j < k; j++)
+		if (COMBOKIND(playvalue(sub[j])) == FLUSH) 
+		    moves[n++].cards = sub[j];
+	/* full houses and four of a kinds */
+	for (i = 0; i < 13; i++) 
+	{
+	    if (popcount(rank[i]) == 4) for (j = 0; j < NUMCARDS; j++)
+		if ((cards & ~rank[i]) & CARDBIT(j)) 
+		    moves[n++].cards = rank[i] | CARDBIT(j);
+	    if (popcount(rank[i]) >= 3) for (j = 0; j < 13; j++) 
+		if ((j != i) && (popcount(rank[j]) >= 2))
+		    for (t = picks(rank[i], 3, 0, trio); t--; )
+			for (d = picks(rank[j], 2, 0, duo); d--; )
+			    moves[n++].cards = trio[t] | duo[d];
+	}
+    }
+    /* keep those that are allowed */
+    for (i = j = 0; i < n; i++)
+    {
+	moves[i].value = playvalue(moves[i].cards);
+	if ((moves[i].value > betterthis) && 
+	    ((firstdrop != 2) || (moves[i].cards & CARDBIT(0))))
+	    moves[j++] = moves[i];
+    }
+    return j;
+}
+/******* legal move generator ends here *******/
+
+/* the splitmix64 finalizer, to spread a key over all 64 bits */
+unsigned long long mixkey(unsigned long long z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* the biggest, then the lowest, play that has the lowest card, or none if
+the hand does not hold it.  the plays are kept on the heap, as they are
+too many for the stack of a thread, and not in a static so that games may
+be played on more than one thread at a time */
+static comboval openchoice(struct GameState *g, int who, comboval betterthis,
+    cardmask *pick)
+{
+    struct MoveStruct *moves;
+    comboval v;
+    int i, n, best;
+
+    if (!(moves = malloc(MAXMOVES * sizeof(struct MoveStruct))))
+	fatal("no room for the opening plays");
+    n = genmoves(g, who, 2, betterthis, moves);
+    for (best = -1, i = 0; i < n; i++) if ((best < 0) ||
+	(popcount(moves[i].cards) > popcount(moves[best].cards)) ||
+	((popcount(moves[i].cards) == popcount(moves[best].cards)) &&
+	(moves[i].value < moves[best].value))) best = i;
+    v = 0;
+    if (best >= 0)
+    {
+	*pick = moves[best].cards;
+	v = moves[best].value;
+    }
+    free(moves);
+    return v;
+}
+
+/* puts the cards of the play chosen for hand who in *pick */
+static comboval findchoice(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, cardmask *pick)
+{
+    int stry, sbetter; /* used when searching for the opening combo */
+
+    *pick = 0;
+    if (firstdrop == 2) return openchoice(g, who, betterthis, pick);
+    if (firstdrop)
+    {
+	if (betterthis) stry = g->hand[MAXPLAYERS + 1].held;
+	else stry = 5;
+	sbetter = COMBOKEY(betterthis);
+	while (stry > 0)
+	{
+	    do
+	    {
+		switch (stry)
+		{
+		    case 5:
+			sbetter = lookfor5(g, who, sbetter, pick);
+			break;
+		    case 3:
+			sbetter = lookfor3(g, who, sbetter, pick);
+			break;
+		    case 2:
+			sbetter = lookfor2(g, who, sbetter, pick);
+			break;
+		    case 1:
+			sbetter = lookfor1(g, who, sbetter, pick);
+			break;
+		    default:
+			fatal("stry set to invalid value in makechoice");
+		}
+		if (sbetter) return playvalue(*pick);
+	    }
+	    while (sbetter > 0);
+	    if (--stry == 4) stry--;
+	}
+	fatal("no choice found for first throw.");
+    }
+    /* the finders rate a straight flush they come across as a straight or
+    a flush, so the value returned is that of the cards picked */
+    sbetter = COMBOKEY(betterthis);
+    switch (g->hand[MAXPLAYERS + 1].held)
+    {
+	case 5:
+	    sbetter = lookfor5(g, who, sbetter, pick);
+	    break;
+	case 3:
+	    sbetter = lookfor3(g, who, sbetter, pick);
+	    break;
+	case 2:
+	    sbetter = lookfor2(g, who, sbetter, pick);
+	    break;
+	case 1:
+	    sbetter = lookfor1(g, who, sbetter, pick);
+	    break;
+	default:
+	    fatal("internal error 2 in makechoice().\n");
+    }
+    return sbetter ? playvalue(*pick) : 0;
+}
+
+/* the plan of a hand:  the fewest plays it can go out in, worked out for
+each set of its cards as they are asked for (a DP over the bit masks of
+the hand, with the answers kept), so that after a drop the plan of what
+is left is most often there already */
+static int planturns(struct HandPlan *p, unsigned int sub)
+{
+    int i, t, low, best;
+
+    if (!sub) return 0;
+    if (p->turns[sub]) return p->turns[sub] - 1;
+    /* the lowest card has to go in some play, and only plays whose lowest
+    card it is fit in what is left */
+    low = lowcard(sub);
+    for (best = 99, i = p->start[low]; i < p->start[low + 1]; i++)
+	if (!(p->play[i] & ~sub))
+    {
+	t = 1 + planturns(p, sub & ~p->play[i]);
+	if (t < best) best = t;
+    }
+    p->turns[sub] = best + 1;
+    return best;
+}
+
+/* the cards of m in the plan's own bits */
+static unsigned int planbits(struct HandPlan *p, cardmask m)
+{
+    unsigned int sub = 0;
+
+    for (; m; m &= m - 1) sub |= 1 << p->bit[lowcard(m)];
+    return sub;
+}
+
+/* the plan of hand who, started afresh if the hand has cards its plan
+does not, or NULL if it holds too many cards to plan for */
+static struct HandPlan *getplan(struct GameState *g, int who)
+{
+    struct HandPlan *p = &g->planner->hand[who];
+    struct MoveStruct *moves = g->planner->moves;
+    cardmask cards = g->hand[who].cards;
+    unsigned int sub;
+    int i, n, low, deck[NUMCARDS];
+
+    if (p->cards && !(cards & ~p->cards)) return p;
+    if (g->hand[who].held > PLANCARDS) return NULL;
+    p->cards = cards;
+    n = maskcards(cards, deck);
+    for (i = 0; i < n; i++) p->bit[deck[i]] = i;
+    for (i = 0; i < (1 << n); i++) p->turns[i] = 0;
+    /* every play of the hand, by its lowest card */
+    n = genmoves(g, who, 1, 0, moves);
+    for (p->nplays = 0, low = 0; low < g->hand[who].held; low++)
+    {
+	p->start[low] = p->nplays;
+	for (i = 0; i < n; i++)
+	    if (lowcard(sub = planbits(p, moves[i].cards)) == low) 
+		p->play[p->nplays++] = sub;
+    }
+    p->start[low] = p->nplays;
+    return p;
+}
+
+/* makechoice() for a hand with a plan:  of the legal plays the one that
+leaves the fewest plays to go out, the biggest and then the lowest when in
+control, else the lowest.  a play that would take more turns to go out
+than passing is not made. */
+static comboval planchoice(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, cardmask *pick)
+{
+    struct HandPlan *p;
+    struct MoveStruct *moves = g->planner->moves;
+    unsigned int all;
+    int i, n, t, now, best = -1, bestt = 0;
+
+    if (!(p = getplan(g, who))) 
+	return findchoice(g, who, firstdrop, betterthis, pick);
+    *pick = 0;
+    all = planbits(p, g->hand[who].cards);
+    now = planturns(p, all);
+    n = genmoves(g, who, firstdrop, betterthis, moves);
+    for (i = 0; i < n; i++)
+    {
+	t = planturns(p, all & ~planbits(p, moves[i].cards));
+	if ((best < 0) || (t < bestt) || ((t == bestt) && (firstdrop &&
+	    (COMBOCARDS(moves[i].value) > COMBOCARDS(moves[best].value)))) ||
+	    ((t == bestt) && (COMBOCARDS(moves[i].value) == 
+	    COMBOCARDS(moves[best].value)) && 
+	    (moves[i].value < moves[best].value)))
+	{
+	    best = i; bestt = t;
+	}
+    }
+    if ((best < 0) || (!firstdrop && (bestt > now))) return 0;
+    *pick = moves[best].cards;
+    return moves[best].value;
+}
+
+/* sets up pl with no plans yet */
+void initplanner(struct Planner *pl)
+{
+    int i;
+
+    for (i = 0; i < MAXPLAYERS; i++) pl->hand[i].cards = 0;
+}
+
+/* sets up c to cache choices in the n (at least 4) slots at slot, n being
+rounded down to 4 times a power of 2 */
+void initcache(struct ChoiceCache *c, struct ChoiceEntry *slot, int n)
+{
+    unsigned int i, room = n;
+
+    for (c->buckets = 1; c->buckets * 8 <= room; c->buckets *= 2);
+    c->slot = slot;
+    for (i = 0; i < c->buckets * 4; i++)
+    {
+	slot[i].cards = 0;
+	slot[i].hand = 0;
+    }
+    c->hits = c->misses = 0;
+}
+
+/* makechoice() with the answer taken from g->cache if it is there */
+comboval makechoice(struct GameState *g, int who, int firstdrop,
+    comboval betterthis, cardmask *pick)
+{
+    struct ChoiceCache *c = g->cache;
+    struct ChoiceEntry *e;
+    cardmask cards = g->hand[who].cards;
+    comboval v;
+    int i, lastheld;
+
+    if (g->planner) return planchoice(g, who, firstdrop, betterthis, pick);
+    if (!c || !cards) return findchoice(g, who, firstdrop, betterthis, pick);
+    /* the size of the last play counts only when it has to be matched */
+    lastheld = ((firstdrop == 2) || (firstdrop && !betterthis)) ? 0 :
+	g->hand[MAXPLAYERS + 1].held;
+    e = c->slot + 4 * (mixkey(g->hand[who].key ^ betterthis ^ 
+	((unsigned long long)firstdrop << 32) ^ 
+	((unsigned long long)lastheld << 40)) & (c->buckets - 1));
+    for (i = 0; i < 4; i++) if ((e[i].cards == cards) && 
+	(e[i].betterthis == betterthis) && (e[i].firstdrop == firstdrop) &&
+	(e[i].lastheld == lastheld))
+    {
+	c->hits++;
+	e[i].used = 1;
+	*pick = e[i].pick;
+	return e[i].value;
+    }
+    c->misses++;
+    v = findchoice(g, who, firstdrop, betterthis, pick);
+    /* an empty slot, else the first from the bucket's hand on not used
+    since the hand last passed it, the hand going on past it */
+    for (i = 0; (i < 4) && e[i].cards; i++);
+    if (i == 4)
+    {
+	for (i = e->hand; e[i].used; i = (i + 1) % 4) e[i].used = 0;
+	e->hand = (i + 1) % 4;
+    }
+    e[i].cards = cards;
+    e[i].betterthis = betterthis;
+    e[i].firstdrop = firstdrop;
+    e[i].lastheld = lastheld;
+    e[i].pick = *pick;
+    e[i].value = v;
+    e[i].used = 1;
+    return v;
+}
+
+int onewon(struct GameState *g)
+{
+    int i;
+
+    for (i = 0; i < g->numplayers; i++) if (!g->hand[i].held) 
+    {
+	g->hand[i].held = 60; return i + 1; /* set held to 60 when one wins */
+    }
+    return 0;
+}
+
+int onehaslost(struct GameState *g)
+{
+    int i, k = 0;
+
+    for (i = 0; i < g->numplayers; i++)
+	if (g->hand[i].held != 60) k++;
+    return k == 1;
+}
+
+/* throws combo from hand who if the rules allow it, returning its value,
+else returns 0 */
+comboval validate(struct GameState *g, int who, int firstdrop, 
+    comboval betterthis, cardmask combo)
+{
+    comboval v = playvalue(combo);
+
+    if (!v || (v <= betterthis) || (combo & ~g->hand[who].cards)) return 0;
+    if (!firstdrop && (COMBOCARDS(v) != g->hand[MAXPLAYERS + 1].held))
+	return 0;
+    if ((firstdrop == 2) && !(combo & CARDBIT(0))) return 0;
+    dropcombo(g, who, combo);
+    return v;
+}
+
+/* called when a successful combo is found */
+comboval reportcombo(struct GameState *g, char *mes, char *whos)
+{
+    comboval j = playvalue(g->hand[MAXPLAYERS + 1].cards);
+
+    sprintf(mes, "%s threw %s (%d).", whos, kindname[COMBOKIND(j)], 
+	COMBOKEY(j));
+    return j;
+}
+
+/* deals a new game and gives the turn to the one with the lowest card */
+void newgame(struct GameState *g)
+{
+    shuffle(g);
+    g->turn = whosfirst(g);
+    g->firstdrop = 2;
+    g->lastthrow = -1;
+    g->cntrlflag = 0;
+    g->betterthis = 0;
+}
+
+/* the hand to play throws the cards in combo, or passes if there are none,
+and the turn goes on as in the terminal game.  returns 0, leaving the game
+as it was, if the throw is not allowed. */
+int playmove(struct GameState *g, cardmask combo)
+{
+    comboval v;
+
+    if (combo)
+    {
+	if (!(v = validate(g, g->turn, g->firstdrop, g->betterthis, combo)))
+	    return 0;
+	g->betterthis = v;
+	if (g->cntrlflag) g->cntrlflag--;
+	g->lastthrow = g->turn;
+	g->firstdrop = 0;
+    }
+    else
+    {
+	if (g->cntrlflag)
+	{
+	    g->lastthrow = g->turn;
+	    g->cntrlflag--;
+	}
+	if (g->firstdrop == 2) g->firstdrop--;
+    }
+    while (g->hand[g->turn = (g->turn + 1) % g->numplayers].held == 60);
+    if (onewon(g))
+    {
+	g->firstdrop = 1;
+	if (!onehaslost(g) && g->controlmode)
+	{
+	    g->firstdrop = 0; g->cntrlflag = 1;
+	}
+	else g->betterthis = 0;
+    }
+    if (g->lastthrow == g->turn)
+    {
+	g->firstdrop = 1; g->betterthis = 0;
+    }
+    return 1;
+}
+
+/* a 64 bit key for where the game stands:  the cards of each player, the
+last play and the turn state kept by playmove().  each hand keeps the 
+Zobrist key of its cards up to date as cards come and go, and so does any
+copy of it, so this only has to mix in which seat holds which */
+unsigned long long gamekey(struct GameState *g)
+{
+    unsigned long long k;
+    int i;
+
+    k = mixkey(zseat[MAXPLAYERS + 1] ^ g->betterthis ^ 
+	((unsigned long long)g->turn << 32) ^ 
+	((unsigned long long)g->firstdrop << 36) ^
+	((unsigned long long)(g->lastthrow + 1) << 40) ^
+	((unsigned long long)g->cntrlflag << 48));
+    for (i = 0; i < g->numplayers; i++) 
+	k ^= mixkey(zseat[i] ^ g->hand[i].key);
+    return k ^ mixkey(zseat[MAXPLAYERS] ^ g->hand[MAXPLAYERS + 1].key);
+}